@@ -15,6 +15,12 @@
  *	.data	-- initialized data
  *	.bss/.sbss -- uninitialized data (should be zero'd on program startup)
  *
+ * The code segment is page-aligned in the NOFF file, and padded with
+ * zeros to a whole number of pages when nothing else is mapped in its
+ * last page (test/script starts the data on a page boundary), so that
+ * the kernel can share code pages between processes running the same
+ * program, reading each straight from the file.
+ *
  * Copyright (c) 1992-1993 The Regents of the University of California.
  * All rights reserved.  See copyright.h for copyright notice and limitation 
  * of liability and disclaimer of warranty provisions.
@@ -70,6 +76,12 @@ ShortToHost(unsigned short shortword) {
 
 extern char *malloc();
 
+#define PageSize    128     /* the smallest page size the kernel runs with
+                               (a disk sector; see machine/machine.h) --
+                               padding the file to 4K pages would overflow
+                               the file system's largest file */
+#define RoundUp(n)  (((n) + PageSize - 1) / PageSize * PageSize)
+
 char *noffFileName = NULL;
 
 /* read and check for error */
@@ -90,6 +102,26 @@ void Write(int fd, char *buf, int nBytes) {
     }
 }
 
+/* write zeros from "from" up to "to" */
+void Pad(int fd, int from, int to) {
+    char zeros[PageSize];
+
+    bzero(zeros, PageSize);
+    if (to > from)
+        Write(fd, zeros, to - from);
+}
+
+/* the lowest address above "addr" that another section starts at */
+int NextSection(struct scnhdr *sections, int numsections, int addr) {
+    int i, next = INT_MAX;
+
+    for (i = 0; i < numsections; i++)
+        if (sections[i].s_size != 0 && sections[i].s_paddr > addr &&
+            sections[i].s_paddr < next)
+            next = sections[i].s_paddr;
+    return next;
+}
+
 main(int argc, char **argv) {
     int fdIn, fdOut, numsections, i, inNoffFile;
     struct filehdr fileh;
@@ -168,6 +200,8 @@ main(int argc, char **argv) {
         if (sections[i].s_size == 0) {
             /* do nothing! */
         } else if (!strcmp(sections[i].s_name, ".text")) {
+            Pad(fdOut, inNoffFile, RoundUp(inNoffFile));
+            inNoffFile = RoundUp(inNoffFile);
             noffH.code.virtualAddr = sections[i].s_paddr;
             noffH.code.inFileAddr = inNoffFile;
             noffH.code.size = sections[i].s_size;
@@ -177,6 +211,13 @@ main(int argc, char **argv) {
             Write(fdOut, buffer, sections[i].s_size);
             free(buffer);
             inNoffFile += sections[i].s_size;
+            if ((sections[i].s_paddr % PageSize) == 0 &&
+                NextSection(sections, numsections, sections[i].s_paddr) >=
+                sections[i].s_paddr + RoundUp(sections[i].s_size)) {
+                noffH.code.size = RoundUp(sections[i].s_size);
+                Pad(fdOut, inNoffFile, noffH.code.inFileAddr + noffH.code.size);
+                inNoffFile = noffH.code.inFileAddr + noffH.code.size;
+            }
         } else if (!strcmp(sections[i].s_name, ".data")
                    || !strcmp(sections[i].s_name, ".rdata")) {
             /* need to check if we have both .data and .rdata
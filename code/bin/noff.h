@@ -5,6 +5,9 @@
  *	code (read-only), initialized data, and unitialized data
  */
 
+#ifndef NOFF_H
+#define NOFF_H
+
 #define NOFFMAGIC    0xbadfad    /* magic number denoting Nachos
 					 * object code file 
 					 */
@@ -32,3 +35,5 @@ typedef struct noffHeader {
 				 * should be zero'ed before use 
 				 */
 } NoffHeader;
+
+#endif /* NOFF_H */
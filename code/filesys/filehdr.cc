@@ -150,6 +150,38 @@ FileHeader::ByteToSector(int offset) {
     return (dataSectors[offset / SectorSize]);
 }
 
+//----------------------------------------------------------------------
+// FileHeader::TransferSectors
+// 	Move "count" bytes of the file, from "position" (a multiple of
+//	the sector size) on, between its data sectors and "data", whole
+//	sectors at a time and with no copy in between.  Runs of sectors
+//	that are consecutive on disk go in one request.
+//
+//	"writing" -- TRUE to write "data" to the file, FALSE to read
+//		the file into "data"
+//----------------------------------------------------------------------
+
+void
+FileHeader::TransferSectors(int position, int count, char *data,
+                            bool writing) {
+    int sectors = divRoundUp(count, SectorSize);
+
+    ASSERT(position % SectorSize == 0);
+    for (int s = 0; s < sectors;) {
+        int sector = ByteToSector(position + s * SectorSize);
+        int n = 1;
+
+        while (s + n < sectors &&
+               ByteToSector(position + (s + n) * SectorSize) == sector + n)
+            n++;
+        if (writing)
+            synchDisk->WriteSectors(sector, n, data + s * SectorSize);
+        else
+            synchDisk->ReadSectors(sector, n, data + s * SectorSize);
+        s += n;
+    }
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FileLength
 // 	Return the number of bytes in the file.
@@ -68,6 +68,11 @@ public:
     // to the disk sector containing
     // the byte
 
+    void TransferSectors(int position, int count, char *data,
+                         bool writing);
+    // Move whole sectors of the file, from
+    // "position" on, to or from "data"
+
     int FileLength();            // Return the length of the file
     // in bytes
 
@@ -31,7 +31,8 @@
 //
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
+//	   the directory and bitmap are guarded by one reader-writer
+//	     lock; open files themselves are not synchronized
 //	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
@@ -51,6 +52,10 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#ifdef VM
+#include "system.h"
+#endif
+#include "synch.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -81,6 +86,7 @@
 FileSystem::FileSystem(bool format)
 {
     DEBUG('f', "Initializing the file system.\n");
+    dirLock = new RWLock("directory lock");
     if (format) {
         BitMap *freeMap = new BitMap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
@@ -168,8 +174,8 @@ FileSystem::FileSystem(bool format)
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+// 	The directory lock is held for writing across the whole operation,
+//	so two threads can't both find the same free sector or entry.
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -188,6 +194,7 @@ FileSystem::Create(char *name, int initialSize)
 
     // lab5: 首先创建 Directory，将磁盘上的 **目录表** 同步到内存中。
     //  使用 FetchFrom 方法
+    dirLock->WriteAcquire();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
 
@@ -221,6 +228,7 @@ FileSystem::Create(char *name, int initialSize)
         delete freeMap;
     }
     delete directory;
+    dirLock->WriteRelease();
     return success;
 }
 
@@ -231,6 +239,9 @@ FileSystem::Create(char *name, int initialSize)
 //	  Find the location of the file's header, using the directory
 //	  Bring the header into memory
 //
+//	Lookups only read the directory, so any number of them may run
+//	at once; they wait only for a Create, Remove or Rename.
+//
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
 
@@ -242,14 +253,40 @@ FileSystem::Open(char *name)
     int sector;
 
     DEBUG('f', "Opening file %s\n", name);
+    dirLock->ReadAcquire();
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector >= 0)
         openFile = new OpenFile(sector);	// name was found in directory
+    dirLock->ReadRelease();
     delete directory;
     return openFile;				// return NULL if not found
 }
 
+//----------------------------------------------------------------------
+// FileSystem::Lookup
+// 	Return the sector holding the header of the file called "name",
+//	without bringing the header into memory, or -1 if there is no
+//	such file.  Lets the open-file table share the header of a file
+//	that is already open.
+//
+//	"name" -- the text name of the file to be found
+//----------------------------------------------------------------------
+
+int
+FileSystem::Lookup(char *name)
+{
+    Directory *directory = new Directory(NumDirEntries);
+    int sector;
+
+    dirLock->ReadAcquire();
+    directory->FetchFrom(directoryFile);
+    sector = directory->Find(name);
+    dirLock->ReadRelease();
+    delete directory;
+    return sector;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Remove
 // 	Delete a file from the file system.  This requires:
@@ -272,11 +309,13 @@ FileSystem::Remove(char *name)
     FileHeader *fileHdr;
     int sector;
 
+    dirLock->WriteAcquire();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
     sector = directory->Find(name);
     if (sector == -1) {
         delete directory;
+        dirLock->WriteRelease();
         return FALSE;			 // file not found
     }
     fileHdr = new FileHeader;
@@ -288,9 +327,13 @@ FileSystem::Remove(char *name)
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
     directory->Remove(name);
+#ifdef VM
+    textCache->ForgetFile(sector);      // the sector may be reused
+#endif
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
+    dirLock->WriteRelease();
     delete fileHdr;
     delete directory;
     delete freeMap;
@@ -307,7 +350,9 @@ FileSystem::List()
 {
     Directory *directory = new Directory(NumDirEntries);
 
+    dirLock->ReadAcquire();
     directory->FetchFrom(directoryFile);
+    dirLock->ReadRelease();
     directory->List();
     delete directory;
 }
@@ -368,6 +413,7 @@ bool FileSystem::Rename(char *source, char *dest)
 {
     bool success;
     Directory *directory = new Directory(NumDirEntries);
+    dirLock->WriteAcquire();
     directory->FetchFrom(directoryFile);
 
 //    success = directory->Rename(source,dest);
@@ -378,6 +424,7 @@ bool FileSystem::Rename(char *source, char *dest)
     }
     else
         printf("Rename: file %s not exists.\n",source);
+    dirLock->WriteRelease();
 
     delete directory;
     return success;
@@ -395,6 +442,7 @@ void FileSystem::FormatDisk(bool format)
     FileHeader *dirHdr = new FileHeader;
 
     DEBUG('f', "Formatting the file system.\n");
+    dirLock->WriteAcquire();
 
     // First, allocate space for FileHeaders for the directory and bitmap
     // (make sure no one else grabs these!)
@@ -431,6 +479,7 @@ void FileSystem::FormatDisk(bool format)
     DEBUG('f', "Writing bitmap and directory back to disk.\n");
     freeMap->WriteBack(freeMapFile);	 // flush changes to disk
     directory->WriteBack(directoryFile);
+    dirLock->WriteRelease();
 
     //print each bit in freeMap
     //freeMap->PrintinBit();    //added by han
@@ -497,6 +546,9 @@ void FileSystem::FormatDisk(bool format)
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#ifdef VM
+#include "system.h"
+#endif
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -721,6 +773,9 @@ FileSystem::Remove(char *name) {
     fileHdr->Deallocate(freeMap);        // remove data blocks
     freeMap->Clear(sector);            // remove header block
     directory->Remove(name);
+#ifdef VM
+    textCache->ForgetFile(sector);      // the sector may be reused
+#endif
 
     freeMap->WriteBack(freeMapFile);        // flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
@@ -69,6 +69,8 @@ public:
 #else // FILESYS
 #ifdef MYFILESYS
 
+class RWLock;
+
 class FileSystem {
 public:
     FileSystem(bool format);        // Initialize the file system.
@@ -83,6 +85,9 @@ public:
 
     OpenFile *Open(char *name);    // Open a file (UNIX open)
 
+    int Lookup(char *name);     // the sector of the file's header,
+    // or -1 if there is no such file
+
     bool Remove(char *name);        // Delete a file (UNIX unlink)
 
     void List();            // List all the files in the file system
@@ -108,6 +113,9 @@ private:
     // represented as a file
     OpenFile *directoryFile;        // "Root" directory -- list of
     // file names, represented as a file
+    RWLock *dirLock;            // Lookups (Open, List) share the
+    // directory; Create, Remove and Rename
+    // modify it and the bitmap exclusively
 };
 
 
@@ -31,6 +31,24 @@ OpenFile::OpenFile(int sector) {
     hdr->FetchFrom(sector);
     seekPosition = 0;
     hdrSector = sector;
+    sharedHdr = FALSE;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::OpenFile
+// 	Open a Nachos file whose header is already in memory, shared with
+//	other OpenFiles on the same file.  The header isn't read again,
+//	and isn't ours to delete.
+//
+//	"sector" -- the location on disk of the file header for this file
+//	"header" -- the file header, as it is in memory
+//----------------------------------------------------------------------
+
+OpenFile::OpenFile(int sector, FileHeader *header) {
+    hdr = header;
+    seekPosition = 0;
+    hdrSector = sector;
+    sharedHdr = TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -39,7 +57,8 @@ OpenFile::OpenFile(int sector) {
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile() {
-    delete hdr;
+    if (!sharedHdr)
+        delete hdr;
 }
 
 //----------------------------------------------------------------------
@@ -92,14 +111,18 @@ OpenFile::Write(char *into, int numBytes) {
 //	boundary; however the disk only knows how to read/write a whole disk
 //	sector at a time.  Thus:
 //
+//	The whole sectors in the middle of the request go straight between
+//	the disk and the caller's buffer -- a user page, for the Read and
+//	Write system calls -- with no copy in between and nothing
+//	allocated, however big the request.  Only a partial first or last
+//	sector goes through a sector-sized buffer on the stack:
+//
 //	For ReadAt:
-//	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   We read in the sector, but only copy the part we are interested in.
 //	For WriteAt:
-//	   We must first read in any sectors that will be partially written,
-//	   so that we don't overwrite the unmodified portion.  We then copy
-//	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   We must first read in the sector, so that we don't overwrite the
+//	   unmodified portion.  We then copy in the data that will be
+//	   modified, and write the sector back.
 //
 //	"into" -- the buffer to contain the data to be read from disk
 //	"from" -- the buffer containing the data to be written to disk
@@ -113,8 +136,8 @@ OpenFile::ReadAt(char *into, int numBytes, int position) {
     // lab5: 在初始化一个 OpenFile 的时候，已经将 该文件的文件头
     //  从磁盘同步到内存中，形成了 fileHeader 这个结构了
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int skip, whole, done = 0;
+    char buf[SectorSize];       // a partial first or last sector
 
     if ((numBytes <= 0) || (position >= fileLength))
         return 0;                // check request
@@ -123,22 +146,21 @@ OpenFile::ReadAt(char *into, int numBytes, int position) {
     DEBUG('f', "Reading %d bytes at %d, from file of length %d.\n",
           numBytes, position, fileLength);
 
-    // lab5:
-    //  position / SectorSize 在这个文件所控制的所有文件块中，计算得到我们从第几个块开始读取
-    //  position + numByted - 1 在这个文件所控制的所有文件块中，我们最终结束的位置在第几个块中
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
-                              &buf[(i - firstSector) * SectorSize]);
-
-    // copy the part we want
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete[] buf;
+    skip = position % SectorSize;
+    if (skip != 0) {            // starts part way into a sector
+        done = min(numBytes, SectorSize - skip);
+        synchDisk->ReadSector(hdr->ByteToSector(position), buf);
+        bcopy(&buf[skip], into, done);
+    }
+    whole = (numBytes - done) / SectorSize * SectorSize;
+    if (whole > 0) {
+        hdr->TransferSectors(position + done, whole, into + done, FALSE);
+        done += whole;
+    }
+    if (done < numBytes) {      // ends part way into a sector
+        synchDisk->ReadSector(hdr->ByteToSector(position + done), buf);
+        bcopy(buf, into + done, numBytes - done);
+    }
     return numBytes;
 }
 
@@ -146,9 +168,8 @@ OpenFile::ReadAt(char *into, int numBytes, int position) {
 int
 OpenFile::WriteAt(char *from, int numBytes, int position) {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int skip, whole, count, sector, done = 0;
+    char buf[SectorSize];       // a partial first or last sector
 
 //    if ((numBytes <= 0) || (position >= fileLength))
 //        return 0;                // check request
@@ -178,37 +199,27 @@ OpenFile::WriteAt(char *from, int numBytes, int position) {
     DEBUG('f', "Writing %d bytes at %d, from file of length %d.\n",
           numBytes, position, fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-
-    // lab5: 检查开始写的位置是不是这个块的起始位置
-    //       检查最终结束的位置是不是最终块的end位置（下一个块的起始）
-    firstAligned = (bool) (position == (firstSector * SectorSize));
-    lastAligned = (bool) ((position + numBytes) == ((lastSector + 1) * SectorSize));
-
-// read in first and last sector, if they are to be partially modified
-    // lab5: 首先把他们的开头结尾都读出来
-    if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize],
-               SectorSize, lastSector * SectorSize);
-
-// copy in the bytes we want to change
-    // lab5: 实际上是做了这样的操作
-    //  [ 起始块 ] [] [] ... [] [ 终止块 ] (逻辑文件示意图)
-    //     |------- bcopy修改的 ----|
-    //  开头结尾各有部分不变
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
-
-// write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
-                               &buf[(i - firstSector) * SectorSize]);
-    delete[] buf;
+    // lab5: 开头结尾不满一个块的部分，先读出整个块，改了再写回
+    skip = position % SectorSize;
+    if (skip != 0) {            // starts part way into a sector
+        done = min(numBytes, SectorSize - skip);
+        sector = hdr->ByteToSector(position);
+        synchDisk->ReadSector(sector, buf);
+        bcopy(from, &buf[skip], done);
+        synchDisk->WriteSector(sector, buf);
+    }
+    whole = (numBytes - done) / SectorSize * SectorSize;
+    if (whole > 0) {
+        hdr->TransferSectors(position + done, whole, from + done, TRUE);
+        done += whole;
+    }
+    if (done < numBytes) {      // ends part way into a sector
+        count = numBytes - done;
+        sector = hdr->ByteToSector(position + done);
+        synchDisk->ReadSector(sector, buf);
+        bcopy(from + done, buf, count);
+        synchDisk->WriteSector(sector, buf);
+    }
     return numBytes;
 }
 
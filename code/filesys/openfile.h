@@ -63,6 +63,8 @@ public:
         return Tell(file);
     }
 
+    int HeaderSector() { return -1; }   // no Nachos disk, no sectors
+
 private:
     int file;
     int currentOffset;
@@ -76,9 +78,17 @@ class FileHeader;
 
 class OpenFile {
 public:
-    OpenFile(char *type) {}
+    OpenFile(char *type) {      // the console: no header at all
+        hdr = NULL;
+        seekPosition = 0;
+        hdrSector = -1;
+        sharedHdr = FALSE;
+    }
     OpenFile(int sector);        // Open a file whose header is located
     // at "sector" on the disk
+    OpenFile(int sector, FileHeader *header);   // ... and already in
+    // memory as "header", which the caller
+    // owns (see ../userprog/filetable.h)
     ~OpenFile();            // Close the file
 
     void Seek(int position);        // Set the position from which to
@@ -116,6 +126,9 @@ public:
         int file = 0;  //stdin
         return ReadPartial(file, into, numBytes);
     }
+
+    int HeaderSector() { return hdrSector; }    // which file this is
+
 private:
     // lab5: OpenFile 实际上操作的是？ SynchDisk
     //  我们根据 sector 号 来操作文件
@@ -126,6 +139,7 @@ private:
     FileHeader *hdr;            // Header for this file
     int seekPosition;            // Current position within the file
     int hdrSector;
+    bool sharedHdr;             // is "hdr" someone else's to delete?
 };
 
 #else
@@ -175,6 +189,8 @@ public:
         return ReadPartial(file, into, numBytes);
     }
 
+    int HeaderSector() { return hdrSector; }    // which file this is
+
 private:
     FileHeader *hdr;            // Header for this file
     int seekPosition;            // Current position within the file
@@ -95,6 +95,35 @@ SynchDisk::WriteSector(int sectorNumber, char *data) {
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors, SynchDisk::WriteSectors
+// 	Read or write "count" consecutive sectors, starting at "first",
+//	from or to "data".  The disk is held for the whole transfer, so
+//	the sectors go by back to back -- after the first, each is on the
+//	same track or the next -- instead of taking turns with other
+//	threads' requests and paying a seek each time.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int first, int count, char *data) {
+    lock->Acquire();
+    for (int i = 0; i < count; i++) {
+        disk->ReadRequest(first + i, data + i * SectorSize);
+        semaphore->P();
+    }
+    lock->Release();
+}
+
+void
+SynchDisk::WriteSectors(int first, int count, char *data) {
+    lock->Acquire();
+    for (int i = 0; i < count; i++) {
+        disk->WriteRequest(first + i, data + i * SectorSize);
+        semaphore->P();
+    }
+    lock->Release();
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
 // 	Disk interrupt handler.  Wake up any thread waiting for the disk
@@ -39,6 +39,12 @@ public:
     // then wait until the request is done.
     void WriteSector(int sectorNumber, char *data);
 
+    void ReadSectors(int first, int count, char *data);
+    void WriteSectors(int first, int count, char *data);
+    // Transfer "count" consecutive sectors
+    // as one operation: no other request
+    // gets in between them.
+
     void RequestDone();            // Called by the disk device interrupt
     // handler, to signal that the
     // current disk operation is complete.
@@ -14,11 +14,13 @@
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
-//              -z
+//              -z -rb
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
+//    -rb (first flag only) runs the ring buffer benchmark instead of
+//       the producer/consumer test
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
@@ -57,7 +59,8 @@
 
 // External functions used by this file
 
-extern void ProdCons(void), Copy(char *unixFile, char *nachosFile);
+extern void ProdCons(void), RingBench(void);
+extern void Copy(char *unixFile, char *nachosFile);
 
 extern void Print(char *file), PerformanceTest(void);
 
@@ -89,7 +92,10 @@ main(int argc, char **argv) {
     (void) Initialize(argc, argv);
 
 #ifdef THREADS
-    ProdCons();
+    if (argc > 1 && !strcmp(argv[1], "-rb"))
+        RingBench();            // compare ring buffer implementations
+    else
+        ProdCons();
 #endif
 
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
@@ -23,6 +23,7 @@
 
 #include "synch.h"
 #include "ring.h"
+#include "ringbuf.h"
 
 #include "string.h"
 
@@ -217,3 +218,111 @@ ProdCons() {
     };
 }
 
+
+//----------------------------------------------------------------------
+// RingBench
+// 	Time the semaphore-guarded Ring above against the lock-free rings
+//	in ringbuf.cc.  Each variant moves the same messages between the
+//	same number of producers and consumers through an 8-slot buffer;
+//	the cost is reported in simulated ticks, along with how many times
+//	a lock-free ring had to put a thread to sleep.
+//----------------------------------------------------------------------
+
+#define BENCH_MESSG 256  // messages per producer in the benchmark
+#define BENCH_BATCH 8    // items per PutMany/GetMany in the batched runs
+
+static Semaphore *benchDone;
+static int benchPerCons;
+
+static void
+BenchProducer(_int which) {
+    slot message(which, 0);
+
+    for (int num = 0; num < BENCH_MESSG; num++) {
+        message.value = num;
+        nempty->P();
+        mutex->P();
+        ring->Put(&message);
+        mutex->V();
+        nfull->V();
+    }
+    benchDone->V();
+}
+
+static void
+BenchConsumer(_int which) {
+    slot message;
+
+    for (int i = 0; i < benchPerCons; i++) {
+        nfull->P();
+        mutex->P();
+        ring->Get(&message);
+        mutex->V();
+        nempty->V();
+    }
+    benchDone->V();
+}
+
+static int
+SemaphoreRingBench(int nProd, int nCons) {
+    int start, i;
+
+    nfull = new Semaphore("full", 0);
+    nempty = new Semaphore("empty", BUFF_SIZE);
+    mutex = new Semaphore("mutex", 1);
+    ring = new Ring(BUFF_SIZE);
+    benchDone = new Semaphore("bench done", 0);
+    benchPerCons = nProd * BENCH_MESSG / nCons;
+
+    start = stats->totalTicks;
+    for (i = 0; i < nProd; i++)
+        (new Thread("bench producer"))->Fork(BenchProducer, i);
+    for (i = 0; i < nCons; i++)
+        (new Thread("bench consumer"))->Fork(BenchConsumer, i);
+    for (i = 0; i < nProd + nCons; i++)
+        benchDone->P();
+    start = stats->totalTicks - start;
+
+    delete ring;
+    delete nfull;
+    delete nempty;
+    delete mutex;
+    delete benchDone;
+    return start;
+}
+
+static void
+BenchLine(char *variant, int nProd, int nCons, int batch, int ticks,
+          int blocked) {
+    printf("%-18s %4d %4d %5d %8d %7.2f ", variant, nProd, nCons, batch,
+           ticks, (double) ticks / (nProd * BENCH_MESSG));
+    if (blocked < 0)
+        printf("%7s\n", "-");
+    else
+        printf("%7d\n", blocked);
+}
+
+void
+RingBench() {
+    int blocked;
+
+    printf("Ring buffer benchmark, %d messages per producer:\n", BENCH_MESSG);
+    printf("%-18s %4s %4s %5s %8s %7s %7s\n", "variant", "prod", "cons",
+           "batch", "ticks", "per msg", "blocked");
+
+    BenchLine("semaphores", 1, 1, 1, SemaphoreRingBench(1, 1), -1);
+    BenchLine("lock-free spsc", 1, 1, 1,
+              RingBenchmark(FALSE, 1, 1, BENCH_MESSG, 1, &blocked), blocked);
+    BenchLine("lock-free spsc", 1, 1, BENCH_BATCH,
+              RingBenchmark(FALSE, 1, 1, BENCH_MESSG, BENCH_BATCH, &blocked),
+              blocked);
+
+    BenchLine("semaphores", N_PROD, N_CONS, 1,
+              SemaphoreRingBench(N_PROD, N_CONS), -1);
+    BenchLine("lock-free mpmc", N_PROD, N_CONS, 1,
+              RingBenchmark(TRUE, N_PROD, N_CONS, BENCH_MESSG, 1, &blocked),
+              blocked);
+    BenchLine("lock-free mpmc", N_PROD, N_CONS, BENCH_BATCH,
+              RingBenchmark(TRUE, N_PROD, N_CONS, BENCH_MESSG, BENCH_BATCH,
+                            &blocked), blocked);
+}
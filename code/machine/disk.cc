@@ -16,6 +16,7 @@
 #include "copyright.h"
 #include "disk.h"
 #include "system.h"
+#include "trace.h"
 
 // We put this at the front of the UNIX file representing the
 // disk, to make it less likely we will accidentally treat a useful file 
@@ -125,6 +126,8 @@ Disk::ReadRequest(int sectorNumber, char *data) {
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskReads++;
+    TRACE_ARG('B', "disk", "read", TracePidDevices, TraceTidDisk,
+              "sector", sectorNumber);
     interrupt->Schedule(DiskDone, (_int)
     this, ticks, DiskInt);
 }
@@ -145,6 +148,8 @@ Disk::WriteRequest(int sectorNumber, char *data) {
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskWrites++;
+    TRACE_ARG('B', "disk", "write", TracePidDevices, TraceTidDisk,
+              "sector", sectorNumber);
     interrupt->Schedule(DiskDone, (_int)
     this, ticks, DiskInt);
 }
@@ -158,6 +163,7 @@ Disk::WriteRequest(int sectorNumber, char *data) {
 void
 Disk::HandleInterrupt() {
     active = FALSE;
+    TRACE('E', "disk", "", TracePidDevices, TraceTidDisk);
     (*handler)(handlerArg);
 }
 
@@ -23,12 +23,15 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#include "trace.h"
+#include "synchprof.h"
 
 // String definitions for debugging messages
 
 static char *intLevelNames[] = {"off", "on"};
 static char *intTypeNames[] = {"timer", "disk", "console write",
-                               "console read", "network send", "network recv"};
+                               "console read", "network send", "network recv",
+                               "alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -61,7 +64,13 @@ Interrupt::Interrupt() {
     pending = new List();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
+    preempting = FALSE;
     status = SystemMode;
+
+    if (traceEnabled) {             // one trace track per device
+        for (int type = TimerInt; type <= AlarmInt; type++)
+            TraceName(TracePidDevices, type + 1, intTypeNames[type]);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -170,7 +179,9 @@ Interrupt::OneTick() {
         // for a context switch, ok to do it now
         yieldOnReturn = FALSE;
         status = SystemMode;        // yield is a kernel routine
+        preempting = TRUE;          // not the thread's own choice
         currentThread->Yield();
+        preempting = FALSE;
         status = old;
     }
 }
@@ -236,6 +247,7 @@ void
 Interrupt::Halt() {
     printf("Machine halting!\n\n");
     stats->Print();
+    SynchProfilePrint();
     Cleanup();     // Never returns.
 }
 
@@ -315,8 +327,13 @@ Interrupt::CheckIfDue(bool advanceClock) {
     //  2. 到点的去检查是不是(idleMode, TimerInt, 无其他中断)。如果是直接返回。
     //  3. 调用中断处理函数
     if (advanceClock && when > stats->totalTicks) {    // advance the clock
+        int idleStart = stats->totalTicks;
+
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
+        if (traceEnabled)
+            TraceSpan("idle", "idle", TracePidDevices, TraceTidIdle,
+                      idleStart);
     } else if (when > stats->totalTicks) {    // not time yet, put it back
         pending->SortedInsert(toOccur, when);
         return FALSE;
@@ -340,7 +357,11 @@ Interrupt::CheckIfDue(bool advanceClock) {
     // we are now going to be
     // running in the kernel
     // lab3: 调用了 TimerExpired 进而调用 handler
+    TRACE('B', "interrupt", intTypeNames[toOccur->type],
+          TracePidDevices, toOccur->type + 1);
     (*(toOccur->handler))(toOccur->arg);    // call the interrupt handler
+    TRACE('E', "interrupt", intTypeNames[toOccur->type],
+          TracePidDevices, toOccur->type + 1);
     status = old;                // restore the machine status
     inHandler = FALSE;
     delete toOccur;
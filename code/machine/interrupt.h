@@ -52,10 +52,12 @@ enum MachineStatus {
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt is a one-shot wakeup
+// for the kernel Alarm (alarm.h); unlike TimerInt, it keeps the machine
+// running while idle, since a thread is waiting on it.
 enum IntType {
     TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
-    NetworkSendInt, NetworkRecvInt
+    NetworkSendInt, NetworkRecvInt, AlarmInt
 };
 
 // The following class defines an interrupt that is scheduled
@@ -104,6 +106,10 @@ public:
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
 
+    bool getPreempting() { return preempting; } // TRUE while a time
+    void setPreempting(bool p) { preempting = p; } // slice is forcing
+    // the current thread to Yield
+
     void DumpState();            // Print interrupt state
 
 
@@ -133,6 +139,9 @@ private:
     bool inHandler;        // TRUE if we are running an interrupt handler
     bool yieldOnReturn;    // TRUE if we are to context switch
     // on return from the interrupt handler
+    bool preempting;       // TRUE during the Yield caused by
+    // yieldOnReturn; lets the scheduler tell a
+    // preemption from a voluntary Yield
     MachineStatus status;    // idle, kernel mode, user mode
 
     // these functions are internal to the interrupt simulation code
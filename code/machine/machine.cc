@@ -43,32 +43,57 @@ void CheckEndian() {
 #endif
 }
 
+int pageSize = DefaultPageSize;     // -ps may change it before the
+                                    // machine is made
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"tlbEntries", "tlbWays" -- the size and associativity of the TLB,
+//		if there is one (by default, TLBSize entries, fully
+//		associative)
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug) {
+Machine::Machine(bool debug, int tlbEntries, int tlbWays) {
     int i;
 
+    ASSERT(PageSize >= SectorSize && (PageSize & (PageSize - 1)) == 0);
+    ASSERT(NumPhysPages >= 2);
+
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-    tlb[i].valid = FALSE;
+    ASSERT(tlbEntries > 0 && tlbWays > 0 && tlbEntries % tlbWays == 0);
+    tlbSize = tlbEntries;
+    tlbAssoc = tlbWays;
+    tlb = new TranslationEntry[tlbSize];
+    tlbLastUsed = new unsigned int[tlbSize];
+    for (i = 0; i < tlbSize; i++) {
+        tlb[i].valid = FALSE;
+        tlb[i].superPage = FALSE;
+        tlbLastUsed[i] = 0;
+    }
+    tlbASID = 0;
+    tlbSuperPages = FALSE;
+    tlbClock = 0;
     pageTable = NULL;
+    pageTableRoot = NULL;
 #else	// use linear page table
     tlb = NULL;
+    tlbLastUsed = NULL;
+    tlbSize = tlbAssoc = 0;
+    tlbSuperPages = FALSE;
     pageTable = NULL;
+    pageTableRoot = NULL;
 #endif
 
+    llAddr = -1;
     singleStep = debug;
     CheckEndian();
 }
@@ -80,8 +105,10 @@ Machine::Machine(bool debug) {
 
 Machine::~Machine() {
     delete[] mainMemory;
-    if (tlb != NULL)
+    if (tlb != NULL) {
         delete[] tlb;
+        delete[] tlbLastUsed;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -24,17 +24,32 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "pagetable.h"
 #include "disk.h"
 
 // Definitions related to the size, and format of user memory
 
-#define PageSize    SectorSize    // set the page size equal to
-// the disk sector size, for
-// simplicity
+// The page size is a power of two, a whole number of disk sectors, and
+// chosen when Nachos starts (-ps); it must not change once the machine
+// exists.  Physical memory is MemorySize bytes whatever the page size,
+// so larger pages mean fewer frames.
 
-#define NumPhysPages    64 //32
-#define MemorySize    (NumPhysPages * PageSize)
+#define DefaultPageSize 4096
+extern int pageSize;            // bytes per page
+#define PageSize        pageSize
+#define SectorsPerPage  (PageSize / SectorSize)
+
+#define MemorySize      (256 * 1024)
+#define NumPhysPages    (MemorySize / PageSize)
 #define TLBSize        4        // if there is a TLB, make it small
+                                // (the default; see Machine::Machine)
+
+// A superpage maps SuperPageSpan virtual pages, aligned to that many,
+// onto as many physically contiguous, aligned frames, with one TLB
+// entry (see Machine::Translate).
+
+#define SuperPageOrder  4
+#define SuperPageSpan   (1 << SuperPageOrder)
 
 enum ExceptionType {
     NoException,           // Everything ok!
@@ -107,7 +122,8 @@ public:
 
 class Machine {
 public:
-    Machine(bool debug);    // Initialize the simulation of the hardware
+    Machine(bool debug, int tlbEntries = TLBSize, int tlbWays = TLBSize);
+    // Initialize the simulation of the hardware
     // for running user programs
     ~Machine();            // De-allocate the data structures
 
@@ -182,9 +198,50 @@ public:
     TranslationEntry *tlb;        // this pointer should be considered
     // "read-only" to Nachos kernel code
 
+// The TLB holds tlbSize entries, grouped into sets of tlbAssoc ways;
+// page vpn can only be cached in set vpn % (tlbSize / tlbAssoc), which
+// occupies tlb[TLBSet(vpn)] up to tlb[TLBSet(vpn) + tlbAssoc - 1].
+// An entry only matches while tlbASID equals its asid, so the kernel
+// can switch address spaces without emptying the TLB.  tlbLastUsed
+// records, for each entry, when it last translated an address (in
+// lookups, counted by tlbClock) -- more than real hardware tells you,
+// but it lets the kernel replace entries LRU.
+//
+// If tlbSuperPages is set, an entry whose superPage bit is on maps a
+// whole superpage, from virtualPage (aligned) and physicalPage on; it
+// lives in the set of its first page, and is looked for there when
+// vpn's own set has no entry for it.
+
+    int tlbSize;
+    int tlbAssoc;
+    int tlbASID;                // address space being run
+    bool tlbSuperPages;         // may entries map superpages?
+    unsigned int *tlbLastUsed;
+    unsigned int tlbClock;
+
+    int TLBSet(unsigned int vpn) {
+        return (vpn % (tlbSize / tlbAssoc)) * tlbAssoc;
+    }
+
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+// Without a TLB, the machine can also walk a PageTable -- linear,
+// two-level or hashed, whichever was built in (see pagetable.h).  If
+// pageTableRoot is set, it is used instead of the plain array above.
+
+    PageTable *pageTableRoot;
+
+// LL (load linked) and SC (store conditional), from MIPS II, let user
+// programs update a word atomically: SC stores only if nothing can
+// have changed the word since the LL, and says whether it did.  On
+// this uniprocessor, only another thread can, so the reservation is
+// simply dropped on every context switch (see
+// Thread::RestoreUserState).
+
+    int llAddr;                 // address of the last LL, or -1 if
+                                // the reservation is gone
+
 private:
     bool singleStep;        // drop back into the debugger after each
     // simulated instruction
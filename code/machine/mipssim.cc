@@ -275,6 +275,19 @@ Machine::OneInstruction(Instruction *instr) {
             nextLoadValue = value;
             break;
 
+        case OP_LL:             // LW, and reserve the word for SC
+            tmp = registers[instr->rs] + instr->extra;
+            if (tmp & 0x3) {
+                RaiseException(AddressErrorException, tmp);
+                return;
+            }
+            if (!machine->ReadMem(tmp, 4, &value))
+                return;
+            llAddr = tmp;
+            nextLoadReg = instr->rt;
+            nextLoadValue = value;
+            break;
+
         case OP_LWL:
             tmp = registers[instr->rs] + instr->extra;
 
@@ -472,6 +485,21 @@ Machine::OneInstruction(Instruction *instr) {
                 return;
             break;
 
+        case OP_SC:             // SW if the word is still reserved;
+            tmp = registers[instr->rs] + instr->extra;  // rt says if it was
+            if (tmp & 0x3) {
+                RaiseException(AddressErrorException, tmp);
+                return;
+            }
+            if (llAddr == tmp) {
+                if (!machine->WriteMem(tmp, 4, registers[instr->rt]))
+                    return;     // retried after the fault, still reserved
+                registers[instr->rt] = 1;
+            } else
+                registers[instr->rt] = 0;
+            llAddr = -1;
+            break;
+
         case OP_SWL:
             tmp = registers[instr->rs] + instr->extra;
 
@@ -0,0 +1,220 @@
+// pagetable.cc
+//	Routines to create page table entries and account for the memory
+//	a page table takes.  Lookup, the machine's side, is in pagetable.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagetable.h"
+
+//----------------------------------------------------------------------
+// InitSlot
+// 	Set up the slot for virtual page "vpn": not yet mapped, and
+//	nothing known about it.
+//----------------------------------------------------------------------
+
+static void
+InitSlot(PageTableSlot *slot, unsigned int vpn) {
+    slot->entry.virtualPage = vpn;
+    slot->entry.physicalPage = -1;
+    slot->entry.valid = FALSE;
+    slot->entry.readOnly = FALSE;
+    slot->entry.use = FALSE;
+    slot->entry.dirty = FALSE;
+    slot->entry.asid = 0;
+    slot->info.swapSlot = -1;
+    slot->info.copyOnWrite = FALSE;
+    slot->info.recentlyUsed = FALSE;
+    slot->info.prefetched = NotPrefetched;
+}
+
+//----------------------------------------------------------------------
+// PageTable::PageTable
+// 	Initialize a page table for virtual pages 0 .. nPages-1.  Only a
+//	linear table has entries from the start.
+//----------------------------------------------------------------------
+
+PageTable::PageTable(unsigned int nPages) {
+    numPages = nPages;
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    numBlocks = divRoundUp(numPages, PageTableBlock);
+    directory = new PageTableSlot *[numBlocks];
+    for (int i = 0; i < numBlocks; i++)
+        directory[i] = NULL;
+#elif defined(HASHED_PAGE_TABLE)
+    numBuckets = MinHashBuckets;
+    buckets = new HashedEntry *[numBuckets];
+    for (unsigned int i = 0; i < numBuckets; i++)
+        buckets[i] = NULL;
+    numEntries = 0;
+#else
+    slots = new PageTableSlot[numPages];
+    for (unsigned int i = 0; i < numPages; i++)
+        InitSlot(&slots[i], i);
+#endif
+}
+
+PageTable::~PageTable() {
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    for (int i = 0; i < numBlocks; i++)
+        delete[] directory[i];
+    delete[] directory;
+#elif defined(HASHED_PAGE_TABLE)
+    for (unsigned int i = 0; i < numBuckets; i++)
+        while (buckets[i] != NULL) {
+            HashedEntry *e = buckets[i];
+            buckets[i] = e->next;
+            delete e;
+        }
+    delete[] buckets;
+#else
+    delete[] slots;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PageTable::Entry
+// 	Return the entry for virtual page "vpn", creating it -- and in a
+//	two-level table, the rest of its block -- if it doesn't exist.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Entry(unsigned int vpn) {
+    TranslationEntry *entry = Lookup(vpn);
+
+    ASSERT(vpn < numPages);
+    if (entry != NULL)
+        return entry;
+
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    int block = vpn >> PageTableBlockBits;
+    unsigned int first = block << PageTableBlockBits;
+
+    directory[block] = new PageTableSlot[PageTableBlock];
+    for (int i = 0; i < PageTableBlock; i++)
+        InitSlot(&directory[block][i], first + i);
+    entry = &directory[block][vpn - first].entry;
+#elif defined(HASHED_PAGE_TABLE)
+    HashedEntry *e = new HashedEntry;
+
+    if (numEntries >= 2 * (int) numBuckets)
+        Grow();
+    InitSlot(&e->slot, vpn);
+    e->next = buckets[vpn & (numBuckets - 1)];
+    buckets[vpn & (numBuckets - 1)] = e;
+    numEntries++;
+    entry = &e->slot.entry;
+#endif
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// PageTable::Next
+// 	Return the entry that follows "entry" in the table, or the first
+//	entry if "entry" is NULL; NULL when there are no more.  Only
+//	entries that exist are visited, so walking a two-level or hashed
+//	table costs in proportion to the pages that have been touched,
+//	not to the size of the address space.  The order is the table's
+//	own: by virtual page, except in a hashed table.
+//
+//	No entry may be created while the table is being walked.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+PageTable::Next(TranslationEntry *entry) {
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    unsigned int vpn = (entry == NULL) ? 0 : entry->virtualPage + 1;
+
+    while (vpn < numPages) {
+        PageTableSlot *block = directory[vpn >> PageTableBlockBits];
+
+        if (block != NULL)
+            return &block[vpn & (PageTableBlock - 1)].entry;
+        vpn = ((vpn >> PageTableBlockBits) + 1) << PageTableBlockBits;
+    }
+    return NULL;
+#elif defined(HASHED_PAGE_TABLE)
+    unsigned int bucket = 0;
+
+    if (entry != NULL) {
+        HashedEntry *e = (HashedEntry *) entry;
+
+        if (e->next != NULL)
+            return &e->next->slot.entry;
+        bucket = (entry->virtualPage & (numBuckets - 1)) + 1;
+    }
+    for (; bucket < numBuckets; bucket++)
+        if (buckets[bucket] != NULL)
+            return &buckets[bucket]->slot.entry;
+    return NULL;
+#else
+    unsigned int vpn = (entry == NULL) ? 0 : entry->virtualPage + 1;
+
+    return (vpn < numPages) ? &slots[vpn].entry : NULL;
+#endif
+}
+
+#ifdef HASHED_PAGE_TABLE
+//----------------------------------------------------------------------
+// PageTable::Grow
+// 	Double the number of buckets, keeping chains short.  Entries stay
+//	where they are in memory, so pointers to them remain good.
+//----------------------------------------------------------------------
+
+void
+PageTable::Grow() {
+    unsigned int oldSize = numBuckets;
+    HashedEntry **old = buckets;
+
+    numBuckets = 2 * oldSize;
+    buckets = new HashedEntry *[numBuckets];
+    for (unsigned int i = 0; i < numBuckets; i++)
+        buckets[i] = NULL;
+    for (unsigned int i = 0; i < oldSize; i++)
+        while (old[i] != NULL) {
+            HashedEntry *e = old[i];
+            unsigned int b = e->slot.entry.virtualPage & (numBuckets - 1);
+            old[i] = e->next;
+            e->next = buckets[b];
+            buckets[b] = e;
+        }
+    delete[] old;
+}
+#endif
+
+//----------------------------------------------------------------------
+// PageTable::NumEntries, PageTable::Overhead
+// 	How many entries the table holds, and how many bytes it takes,
+//	counting the directory or buckets.
+//----------------------------------------------------------------------
+
+int
+PageTable::NumEntries() {
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    int count = 0;
+
+    for (int i = 0; i < numBlocks; i++)
+        if (directory[i] != NULL)
+            count += PageTableBlock;
+    return count;
+#elif defined(HASHED_PAGE_TABLE)
+    return numEntries;
+#else
+    return numPages;
+#endif
+}
+
+int
+PageTable::Overhead() {
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    return numBlocks * sizeof(PageTableSlot *) +
+           NumEntries() * sizeof(PageTableSlot);
+#elif defined(HASHED_PAGE_TABLE)
+    return numBuckets * sizeof(HashedEntry *) +
+           numEntries * sizeof(HashedEntry);
+#else
+    return numPages * sizeof(PageTableSlot);
+#endif
+}
@@ -0,0 +1,143 @@
+// pagetable.h
+//	Data structures for a page table: the mapping from every virtual
+//	page of an address space to its TranslationEntry, in the form the
+//	machine walks when it translates without a TLB.
+//
+//	The layout is chosen at build time:
+//
+//	  (default)            -- linear: one entry per virtual page, in
+//				  one array; lookups are a single index
+//	  TWO_LEVEL_PAGE_TABLE -- a directory of pointers to blocks of
+//				  PageTableBlock entries, a block being
+//				  allocated only when one of its pages
+//				  is first given an entry
+//	  HASHED_PAGE_TABLE    -- only the entries that exist, chained in
+//				  a hash table on the virtual page number,
+//				  which doubles in size as it fills
+//
+//	Each entry is kept together with what the kernel knows about the
+//	page besides its translation (PageInfo), which the machine never
+//	looks at.
+//
+//	A linear table costs memory in proportion to the size of the
+//	address space, the others roughly in proportion to the pages
+//	actually used -- which matters once address spaces are large and
+//	sparse.  The price is an extra memory reference, or a hash and a
+//	chain walk, per lookup.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include "copyright.h"
+#include "translate.h"
+
+#define PageTableBlockBits  6   // a second-level block maps 64 pages
+#define PageTableBlock      (1 << PageTableBlockBits)
+#define MinHashBuckets      16
+
+// Whether a page was fetched ahead of need, and if so, whether it
+// turned out to be used.
+
+enum PrefetchState { NotPrefetched, Prefetched, PrefetchUsed };
+
+// What the kernel keeps about a virtual page besides its translation.
+// It is stored with the page's entry, so a page that has no entry
+// costs nothing: it has never been touched, so it has no copy in
+// swap, and isn't shared, used or fetched ahead.
+
+class PageInfo {
+public:
+    int swapSlot;               // its copy in swap, or -1
+    bool copyOnWrite;           // mapped read-only only because its
+                                // frame is shared
+    bool recentlyUsed;          // used in the last sample interval
+    PrefetchState prefetched;
+};
+
+// One page's slot in the table.  The machine only sees the entry.
+
+class PageTableSlot {
+public:
+    TranslationEntry entry;     // must come first: see PageTable::Info
+    PageInfo info;
+};
+
+#ifdef HASHED_PAGE_TABLE
+// One slot of a hashed page table, with its chain link.
+
+class HashedEntry {
+public:
+    PageTableSlot slot;         // must come first: see PageTable::Next
+    HashedEntry *next;
+};
+#endif
+
+// The following class defines a page table for "numPages" virtual
+// pages.  Entries are created lazily, except in a linear table, and
+// start out invalid.
+
+class PageTable {
+public:
+    PageTable(unsigned int nPages);
+    ~PageTable();
+
+    TranslationEntry *Lookup(unsigned int vpn); // vpn's entry, or NULL if
+    // it has none (yet); the
+    // machine's page walk
+    TranslationEntry *Entry(unsigned int vpn);  // vpn's entry, created
+    // (invalid) if need be
+    PageInfo *Info(TranslationEntry *entry) {   // the kernel's information
+        return &((PageTableSlot *) entry)->info;    // about the page
+    }                                           // of one of our entries
+    TranslationEntry *Next(TranslationEntry *entry);
+    // the entry after "entry" (the first
+    // if NULL), or NULL after the last
+    unsigned int NumPages() { return numPages; }
+    int NumEntries();           // entries that exist
+    int Overhead();             // bytes of memory the table takes
+
+private:
+    unsigned int numPages;
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    PageTableSlot **directory;  // per block: its slots, or NULL
+    int numBlocks;
+#elif defined(HASHED_PAGE_TABLE)
+    HashedEntry **buckets;
+    unsigned int numBuckets;    // always a power of two
+    int numEntries;
+    void Grow();                // double the number of buckets
+#else
+    PageTableSlot *slots;
+#endif
+};
+
+//----------------------------------------------------------------------
+// PageTable::Lookup
+// 	Return the entry for virtual page "vpn", or NULL if there is none.
+//	This is on the path of every translation, so it is inline.
+//----------------------------------------------------------------------
+
+inline TranslationEntry *
+PageTable::Lookup(unsigned int vpn) {
+    if (vpn >= numPages)
+        return NULL;
+#if defined(TWO_LEVEL_PAGE_TABLE)
+    PageTableSlot *block = directory[vpn >> PageTableBlockBits];
+
+    return (block == NULL) ? NULL : &block[vpn & (PageTableBlock - 1)].entry;
+#elif defined(HASHED_PAGE_TABLE)
+    for (HashedEntry *e = buckets[vpn & (numBuckets - 1)]; e != NULL;
+         e = e->next)
+        if ((unsigned int) e->slot.entry.virtualPage == vpn)
+            return &e->slot.entry;
+    return NULL;
+#else
+    return &slots[vpn].entry;
+#endif
+}
+
+#endif // PAGETABLE_H
@@ -21,6 +21,8 @@ Statistics::Statistics() {
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numTLBHits = numTLBMisses = 0;
+    pageFaultTicks = numPrefetches = numPrefetchHits = 0;
 }
 
 //----------------------------------------------------------------------
@@ -36,7 +38,15 @@ Statistics::Print() {
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead,
            numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, stall ticks %d\n", numPageFaults,
+           pageFaultTicks);
+    if (numPrefetches > 0)
+        printf("Fault-ahead: pages fetched %d, used %d\n", numPrefetches,
+               numPrefetchHits);
+    if (numTLBHits + numTLBMisses > 0)
+        printf("TLB: hits %d, misses %d, hit rate %.2f%%\n", numTLBHits,
+               numTLBMisses,
+               100.0 * numTLBHits / (numTLBHits + numTLBMisses));
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd,
            numPacketsSent);
 }
@@ -33,6 +33,11 @@ public:
     int numConsoleCharsRead;    // number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;        // number of virtual memory page faults
+    int pageFaultTicks;        // time faulting threads waited for pages
+    int numPrefetches;        // pages fetched ahead of a fault
+    int numPrefetchHits;    // ... that turned out to be used
+    int numTLBHits;        // number of translations found in the TLB
+    int numTLBMisses;        // number of translations not in the TLB
     int numPacketsSent;        // number of packets sent over the network
     int numPacketsRecvd;    // number of packets received over the network
 
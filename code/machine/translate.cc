@@ -77,7 +77,8 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //	the location pointed to by "value".
 //
 //   	Returns FALSE if the translation step from virtual to physical memory
-//   	failed.
+//   	failed.  A page fault taken on behalf of the kernel is handled
+//	and retried once, so system calls can touch paged-out memory.
 //
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
@@ -94,6 +95,17 @@ Machine::ReadMem(int addr, int size, int *value) {
 
     // lab6: 这个地址翻译感觉很离谱啊！那么咱们的页表就初始化了一下
     exception = Translate(addr, &physicalAddress, size, FALSE);
+    // a system call touched a page that is not in memory (or the TLB)
+    // yet, or stored to a copy-on-write page: have the kernel fix it
+    // up, then try again (a store may need both; copying on write
+    // leaves the new page in the TLB, so two tries are enough)
+    for (int tries = 0; tries < 2 && interrupt->getStatus() == SystemMode &&
+                        (exception == PageFaultException ||
+                         exception == ReadOnlyException); tries++) {
+        RaiseException(exception, addr);
+        interrupt->setStatus(SystemMode);
+        exception = Translate(addr, &physicalAddress, size, FALSE);
+    }
     if (exception != NoException) {
         machine->RaiseException(exception, addr);
         return FALSE;
@@ -143,6 +155,17 @@ Machine::WriteMem(int addr, int size, int value) {
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
+    // a system call touched a page that is not in memory (or the TLB)
+    // yet, or stored to a copy-on-write page: have the kernel fix it
+    // up, then try again (a store may need both; copying on write
+    // leaves the new page in the TLB, so two tries are enough)
+    for (int tries = 0; tries < 2 && interrupt->getStatus() == SystemMode &&
+                        (exception == PageFaultException ||
+                         exception == ReadOnlyException); tries++) {
+        RaiseException(exception, addr);
+        interrupt->setStatus(SystemMode);
+        exception = Translate(addr, &physicalAddress, size, TRUE);
+    }
     if (exception != NoException) {
         machine->RaiseException(exception, addr);
         return FALSE;
@@ -201,8 +224,8 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
     }
 
     // we must have either a TLB or a page table, but not both!
-    ASSERT(tlb == NULL || pageTable == NULL);
-    ASSERT(tlb != NULL || pageTable != NULL);
+    ASSERT(tlb == NULL || (pageTable == NULL && pageTableRoot == NULL));
+    ASSERT(tlb != NULL || pageTable != NULL || pageTableRoot != NULL);
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
@@ -211,7 +234,17 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
     offset = (unsigned) virtAddr % PageSize;
 
     // lab6: 检查是不是 machine 里设置 tlb 了。
-    if (tlb == NULL) {        // => page table => vpn is index into table
+    if (tlb == NULL && pageTableRoot != NULL) {     // walk the page table
+        entry = pageTableRoot->Lookup(vpn);
+        if (vpn >= pageTableRoot->NumPages()) {
+            DEBUG('a', "virtual page # %d too large for page table size %d!\n",
+                  virtAddr, pageTableRoot->NumPages());
+            return AddressErrorException;
+        } else if (entry == NULL || !entry->valid) {
+            DEBUG('a', "virtual page # %d not mapped\n", virtAddr);
+            return PageFaultException;
+        }
+    } else if (tlb == NULL) { // => page table => vpn is index into table
         // lab6: 如果没有设置 tlb 去检查慢表
         if (vpn >= pageTableSize) {
             DEBUG('a', "virtual page # %d too large for page table size %d!\n",
@@ -226,20 +259,38 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
         entry = &pageTable[vpn];
     } else {
         // lab6: 如果有快表，遍历快表
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-            if (tlb[i].valid && ((unsigned int) tlb[i].virtualPage == vpn)) {
+        // only the ways of vpn's set can hold it
+        int set = TLBSet(vpn);
+        for (entry = NULL, i = set; i < set + tlbAssoc; i++)
+            if (tlb[i].valid && ((unsigned int) tlb[i].virtualPage == vpn)
+                && !tlb[i].superPage && tlb[i].asid == tlbASID) {
                 // lab6: 就找到快表了
                 entry = &tlb[i];            // FOUND!
                 break;
             }
+        if (entry == NULL && tlbSuperPages) {
+            // a superpage's entry is in the set of its first page
+            unsigned int first = vpn & ~(SuperPageSpan - 1);
+            set = TLBSet(first);
+            for (i = set; i < set + tlbAssoc; i++)
+                if (tlb[i].valid && tlb[i].superPage &&
+                    (unsigned int) tlb[i].virtualPage == first &&
+                    tlb[i].asid == tlbASID) {
+                    entry = &tlb[i];
+                    break;
+                }
+        }
         if (entry == NULL) {                // not found
             // lab6: 如果没在tlb里找到快表, 也会报一个 PageFaultException.
             //  感觉很奇怪啊：难道不应该再去查查慢表吗？
             DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+            stats->numTLBMisses++;
             return PageFaultException;        // really, this is a TLB fault,
             // the page may be in memory,
             // but not in the TLB
         }
+        stats->numTLBHits++;
+        tlbLastUsed[i] = ++tlbClock;
     }
 
     // lab6: 检查只读错误
@@ -248,11 +299,13 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing) {
         return ReadOnlyException;
     }
     pageFrame = entry->physicalPage;
+    if (tlb != NULL && entry->superPage)
+        pageFrame += vpn - entry->virtualPage;
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB.
     // lab6: 检查实页号是不是合法
-    if (pageFrame >= NumPhysPages) {
+    if (pageFrame >= (unsigned) NumPhysPages) {
         DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
         return BusErrorException;
     }
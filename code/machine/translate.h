@@ -40,6 +40,11 @@ public:
     // page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
     // page is modified.
+    int asid;           // In a TLB entry, the address space the entry
+    // belongs to: it only matches while the machine
+    // runs with that ASID.  Unused in page tables.
+    bool superPage;     // In a TLB entry: maps SuperPageSpan pages (see
+    // machine.h).  Unused in page tables.
 };
 
 #endif
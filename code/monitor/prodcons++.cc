@@ -25,6 +25,7 @@
 
 #include "synch.h"
 #include "ring.h"
+#include "ringbuf.h"
 
 #define BUFF_SIZE 2  // the size of the round buffer
 #define N_PROD    2  // the number of producers 
@@ -181,3 +182,97 @@ ProdCons() {
     };
 }
 
+
+//----------------------------------------------------------------------
+// RingBench
+// 	Time the Hoare-monitor Ring above against the lock-free rings in
+//	ringbuf.cc.  Each variant moves the same messages between the
+//	same number of producers and consumers through an 8-slot buffer;
+//	the cost is reported in simulated ticks, along with how many times
+//	a lock-free ring had to put a thread to sleep.
+//----------------------------------------------------------------------
+
+#define BENCH_SIZE  8    // slots in every benchmarked buffer
+#define BENCH_MESSG 256  // messages per producer in the benchmark
+#define BENCH_BATCH 8    // items per PutMany/GetMany in the batched runs
+
+static Semaphore *benchDone;
+static int benchPerCons;
+
+static void
+BenchProducer(_int which) {
+    slot message(which, 0);
+
+    for (int num = 0; num < BENCH_MESSG; num++) {
+        message.value = num;
+        ring->Put(&message);
+    }
+    benchDone->V();
+}
+
+static void
+BenchConsumer(_int which) {
+    slot message;
+
+    for (int i = 0; i < benchPerCons; i++)
+        ring->Get(&message);
+    benchDone->V();
+}
+
+static int
+MonitorRingBench(int nProd, int nCons) {
+    int start, i;
+
+    ring = new Ring(BENCH_SIZE);
+    benchDone = new Semaphore("bench done", 0);
+    benchPerCons = nProd * BENCH_MESSG / nCons;
+
+    start = stats->totalTicks;
+    for (i = 0; i < nProd; i++)
+        (new Thread("bench producer"))->Fork(BenchProducer, i);
+    for (i = 0; i < nCons; i++)
+        (new Thread("bench consumer"))->Fork(BenchConsumer, i);
+    for (i = 0; i < nProd + nCons; i++)
+        benchDone->P();
+    start = stats->totalTicks - start;
+
+    delete ring;
+    delete benchDone;
+    return start;
+}
+
+static void
+BenchLine(char *variant, int nProd, int nCons, int batch, int ticks,
+          int blocked) {
+    printf("%-18s %4d %4d %5d %8d %7.2f ", variant, nProd, nCons, batch,
+           ticks, (double) ticks / (nProd * BENCH_MESSG));
+    if (blocked < 0)
+        printf("%7s\n", "-");
+    else
+        printf("%7d\n", blocked);
+}
+
+void
+RingBench() {
+    int blocked;
+
+    printf("Ring buffer benchmark, %d messages per producer:\n", BENCH_MESSG);
+    printf("%-18s %4s %4s %5s %8s %7s %7s\n", "variant", "prod", "cons",
+           "batch", "ticks", "per msg", "blocked");
+
+    BenchLine("hoare monitor", 1, 1, 1, MonitorRingBench(1, 1), -1);
+    BenchLine("lock-free spsc", 1, 1, 1,
+              RingBenchmark(FALSE, 1, 1, BENCH_MESSG, 1, &blocked), blocked);
+    BenchLine("lock-free spsc", 1, 1, BENCH_BATCH,
+              RingBenchmark(FALSE, 1, 1, BENCH_MESSG, BENCH_BATCH, &blocked),
+              blocked);
+
+    BenchLine("hoare monitor", N_PROD, N_CONS, 1,
+              MonitorRingBench(N_PROD, N_CONS), -1);
+    BenchLine("lock-free mpmc", N_PROD, N_CONS, 1,
+              RingBenchmark(TRUE, N_PROD, N_CONS, BENCH_MESSG, 1, &blocked),
+              blocked);
+    BenchLine("lock-free mpmc", N_PROD, N_CONS, BENCH_BATCH,
+              RingBenchmark(TRUE, N_PROD, N_CONS, BENCH_MESSG, BENCH_BATCH,
+                            &blocked), blocked);
+}
@@ -43,11 +43,14 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData) {
 //	can receive incoming messages.
 //
 //	Just initialize a list of messages, representing the mailbox.
+//	The list is bounded, so a mailbox nobody reads from cannot grow
+//	without limit.
 //----------------------------------------------------------------------
 
 
 MailBox::MailBox() {
-    messages = new SynchList();
+    messages = new SynchList(MaxMailBacklog);
+    numDropped = 0;
 }
 
 //----------------------------------------------------------------------
@@ -59,6 +62,8 @@ MailBox::MailBox() {
 //----------------------------------------------------------------------
 
 MailBox::~MailBox() {
+    if (numDropped > 0)
+        DEBUG('n', "Mailbox dropped %d messages, being full\n", numDropped);
     delete messages;
 }
 
@@ -80,7 +85,9 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr) {
 //----------------------------------------------------------------------
 // MailBox::Put
 // 	Add a message to the mailbox.  If anyone is waiting for message
-//	arrival, wake them up!
+//	arrival, wake them up!  If the mailbox is full, drop the message
+//	instead (and count it): this is called by the postal worker,
+//	which can't wait for room without holding up every mailbox.
 //
 //	We need to reconstruct the Mail message (by concatenating the headers
 //	to the data), to simplify queueing the message on the SynchList.
@@ -94,9 +101,13 @@ void
 MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data) {
     Mail *mail = new Mail(pktHdr, mailHdr, data);
 
-    messages->Append((void *) mail);    // put on the end of the list of
-    // arrived messages, and wake up
-    // any waiters
+    if (!messages->TryAppend((void *) mail)) {  // put on the end of the
+        // list of arrived messages, and
+        // wake up any waiters
+        DEBUG('n', "Mailbox %d full, message dropped\n", mailHdr.to);
+        numDropped++;
+        delete mail;
+    }
 }
 
 //----------------------------------------------------------------------
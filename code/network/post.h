@@ -52,6 +52,12 @@ public:
 
 #define MaxMailSize    (MaxPacketSize - sizeof(MailHeader))
 
+// The most messages a mailbox holds.  A message for a mailbox that is
+// full is dropped, as the network may drop any message: the single
+// postal worker must not wait for one receiver while mail for every
+// other mailbox piles up behind it.
+#define MaxMailBacklog    32
+
 
 // The following class defines the format of an incoming/outgoing 
 // "Mail" message.  The message format is layered: 
@@ -89,6 +95,7 @@ public:
     // to get!)
 private:
     SynchList *messages;    // A mailbox is just a list of arrived messages
+    int numDropped;        // messages thrown away because it was full
 };
 
 // The following class defines a "Post Office", or a collection of 
@@ -0,0 +1,26 @@
+/* fork.c
+ *	Simple program to test Fork: the parent and child each change
+ *	their copy of a shared array, then exit with what they see, so
+ *	copy-on-write mixing them up shows in the exit codes.
+ */
+
+#include "syscall.h"
+
+int data[512];      /* several pages, copied only when written */
+
+int main() {
+    SpaceId pid;
+    int i;
+
+    for (i = 0; i < 512; i++)
+        data[i] = i;
+
+    pid = Fork();
+    if (pid == 0) {
+        data[0] = 7;            /* child: copies one page */
+        Exit(data[0] + data[511]);  /* 518 */
+    }
+    data[511] = 1;              /* parent: copies another */
+    Join(pid);
+    Exit(data[0] + data[511]);  /* 1 */
+}
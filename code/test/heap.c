@@ -0,0 +1,63 @@
+/* heap.c
+ *	Simple program to test Sbrk and malloc.h: build a list of records
+ *	of varying sizes, free every other one, allocate them again (which
+ *	should reuse the freed blocks rather than grow the heap), and
+ *	check that nothing was overwritten.  A big block or two, past the
+ *	size classes, go straight to Sbrk.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+#define N 200
+
+typedef struct Record {
+    struct Record *next;
+    int len;
+    char data[1];               /* really "len" bytes */
+} Record;
+
+Record *records[N];
+
+Record *
+NewRecord(int i) {
+    int len = 1 + (i * 37) % 300;
+    Record *r = (Record *) malloc(sizeof(Record) + len);
+    int j;
+
+    if (r == 0)
+        Exit(-1);
+    r->len = len;
+    for (j = 0; j < len; j++)
+        r->data[j] = (char) (i + j);
+    return r;
+}
+
+int
+main() {
+    char *top, *big;
+    int i, j, bad = 0;
+
+    for (i = 0; i < N; i++)
+        records[i] = NewRecord(i);
+    for (i = 0; i < N; i += 2)
+        free(records[i]);
+    top = Sbrk(0);
+    for (i = 0; i < N; i += 2)
+        records[i] = NewRecord(i);
+    if (Sbrk(0) != top)         /* the freed blocks were enough */
+        bad++;
+
+    big = (char *) malloc(3 * ChunkSize);
+    for (i = 0; i < 3 * ChunkSize; i++)
+        big[i] = 1;
+    free(big);
+    if ((char *) malloc(2 * ChunkSize) != big)  /* first fit */
+        bad++;
+
+    for (i = 0; i < N; i++)
+        for (j = 0; j < records[i]->len; j++)
+            if (records[i]->data[j] != (char) (i + j))
+                bad++;
+    Exit(bad);                  /* should be 0! */
+}
@@ -0,0 +1,37 @@
+/* iovec.c
+ *	Simple program to test WriteV and ReadV: write a file from three
+ *	separate buffers in one call, then read it back scattered into
+ *	two differently sized ones.
+ */
+
+#include "syscall.h"
+
+int main() {
+    OpenFileId fd;
+    IoVec iov[3];
+    char head[6], tail[13];
+    int n;
+
+    Create("iofile");
+    fd = Open("iofile");
+    iov[0].base = "gather";
+    iov[0].len = 6;
+    iov[1].base = ", ";
+    iov[1].len = 2;
+    iov[2].base = "scatter!\n";
+    iov[2].len = 9;
+    WriteV(iov, 3, fd);
+    Close(fd);
+
+    fd = Open("iofile");
+    iov[0].base = head;
+    iov[0].len = 6;
+    iov[1].base = tail;
+    iov[1].len = 13;           /* more than is left: stops at the end */
+    n = ReadV(iov, 2, fd);
+    Close(fd);
+
+    iov[1].len = n - 6;
+    WriteV(iov, 2, ConsoleOutput);  /* gather, scatter! */
+    Exit(n == 17 ? 0 : 1);
+}
@@ -0,0 +1,131 @@
+/* malloc.h
+ *	A memory allocator for user programs, on top of Sbrk.
+ *
+ *	Small blocks come in size classes -- powers of two from 16 to
+ *	MaxSmallBlock bytes, header included -- and each class keeps its
+ *	own list of free blocks, so malloc and free are a list pop and
+ *	push.  A class with nothing free is refilled by carving blocks out
+ *	of a chunk of ChunkSize bytes got from Sbrk.  Bigger requests get
+ *	a block of their own (rounded up to a multiple of ChunkSize) from
+ *	Sbrk, and once freed go on a list of big blocks, which malloc
+ *	searches first fit before asking for more.  Nothing is ever given
+ *	back to the kernel.
+ *
+ *	Every block starts with an 8-byte header giving its size, so that
+ *	free knows where to put it back, and what malloc returns is 8-byte
+ *	aligned.
+ *
+ *	Since test/Makefile builds each program from a single .c file,
+ *	this is a header of static functions: #include it in the program.
+ */
+
+#ifndef MALLOC_H
+#define MALLOC_H
+
+#include "syscall.h"
+
+#define MinBlockShift 4             /* the smallest class: 16 bytes */
+#define NumClasses 8                /* 16, 32, ... 2048 */
+#define MaxSmallBlock (1 << (MinBlockShift + NumClasses - 1))
+#define ChunkSize 4096              /* asked of Sbrk at a time */
+#define BlockHeader 8
+
+typedef struct FreeBlock {
+    int size;                       /* the header: bytes, header included */
+    int pad;
+    struct FreeBlock *next;         /* while free, in the user part */
+} FreeBlock;
+
+static FreeBlock *freeLists[NumClasses];    /* per class */
+static FreeBlock *bigBlocks;                /* first fit */
+static char *chunk, *chunkEnd;              /* what is left to carve */
+
+/* Carve a block of "size" bytes from the current chunk, getting another
+ * one if it hasn't room.  What was left of the old chunk is handed out
+ * to the classes it fits, largest first, so that none is wasted. */
+static FreeBlock *
+CarveBlock(int size) {
+    FreeBlock *b;
+    int c, left;
+
+    if (chunkEnd - chunk < size) {
+        for (c = NumClasses - 1; c >= 0; c--) {
+            left = 1 << (MinBlockShift + c);
+            while (chunkEnd - chunk >= left) {
+                b = (FreeBlock *) chunk;
+                b->size = left;
+                b->next = freeLists[c];
+                freeLists[c] = b;
+                chunk += left;
+            }
+        }
+        chunk = Sbrk(ChunkSize);
+        if (chunk == (char *) -1) {
+            chunk = chunkEnd = 0;
+            return 0;
+        }
+        chunkEnd = chunk + ChunkSize;
+    }
+    b = (FreeBlock *) chunk;
+    b->size = size;
+    chunk += size;
+    return b;
+}
+
+static void *
+malloc(int n) {
+    FreeBlock *b, **prev;
+    int c, size;
+
+    if (n < 0)
+        return 0;
+    size = n + BlockHeader;
+    if (size <= MaxSmallBlock) {
+        for (c = 0; (1 << (MinBlockShift + c)) < size; c++)
+            ;
+        b = freeLists[c];
+        if (b != 0)
+            freeLists[c] = b->next;
+        else
+            b = CarveBlock(1 << (MinBlockShift + c));
+    } else {
+        size = (size + ChunkSize - 1) / ChunkSize * ChunkSize;
+        for (prev = &bigBlocks; *prev != 0; prev = &(*prev)->next)
+            if ((*prev)->size >= size)
+                break;
+        b = *prev;
+        if (b != 0)
+            *prev = b->next;
+        else {
+            b = (FreeBlock *) Sbrk(size);
+            if (b == (FreeBlock *) -1)
+                b = 0;
+            else
+                b->size = size;
+        }
+    }
+    if (b == 0)
+        return 0;
+    return (char *) b + BlockHeader;
+}
+
+static void
+free(void *p) {
+    FreeBlock *b;
+    int c;
+
+    if (p == 0)
+        return;
+    b = (FreeBlock *) ((char *) p - BlockHeader);
+    if (b->size > MaxSmallBlock) {
+        b->next = bigBlocks;
+        bigBlocks = b;
+        return;
+    }
+    for (c = 0; (1 << (MinBlockShift + c)) < b->size; c++)
+        ;
+    b->next = freeLists[c];
+    freeLists[c] = b;
+}
+
+#endif /* MALLOC_H */
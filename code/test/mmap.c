@@ -0,0 +1,32 @@
+/* mmap.c
+ *	Simple program to test Mmap: write a file, map it, capitalize it
+ *	in place in memory, and unmap it.  Mapping it again shows whether
+ *	the change made it back to the file.
+ */
+
+#include "syscall.h"
+
+#define N 19
+
+int main() {
+    OpenFileId fd;
+    char *p;
+    int i;
+
+    Create("mmfile");
+    fd = Open("mmfile");
+    Write("hello, mapped file\n", N, fd);
+
+    p = Mmap(fd, 0, N);
+    if (p == (char *) -1)
+        Exit(1);
+    for (i = 0; i < N; i++)
+        if (p[i] >= 'a' && p[i] <= 'z')
+            p[i] -= 'a' - 'A';
+    Munmap(p);                  /* saves the page */
+
+    p = Mmap(fd, 0, N);
+    Write(p, N, ConsoleOutput); /* HELLO, MAPPED FILE */
+    Close(fd);
+    Exit(0);                    /* the mapping goes with the process */
+}
@@ -0,0 +1,61 @@
+/* mutex.c
+ *	Simple program to test the user-level mutexes and condition
+ *	variables of usync.h.  NPROC forked children add to a counter in
+ *	a shared segment under a mutex, Yielding inside the critical
+ *	section so that the others find it held and have to sleep; the
+ *	last to finish signals the parent, which is waiting on a condition
+ *	variable rather than in Join.  Lost updates would show in the
+ *	exit code.
+ */
+
+#include "syscall.h"
+#include "usync.h"
+
+#define NPROC 4
+#define ROUNDS 100
+#define KEY 49
+
+typedef struct {
+    Mutex lock;
+    Cond allDone;
+    int counter;
+    int done;                   /* children finished */
+} Shared;
+
+int
+main() {
+    Shared *s;
+    SpaceId pid;
+    int p, i, tmp;
+
+    s = (Shared *) ShmCreate(KEY, sizeof(Shared));
+    if (s == (Shared *) -1)
+        Exit(-1);
+    MutexInit(&s->lock);
+    CondInit(&s->allDone);
+
+    for (p = 0; p < NPROC; p++) {
+        pid = Fork();
+        if (pid == 0) {
+            for (i = 0; i < ROUNDS; i++) {
+                MutexLock(&s->lock);
+                tmp = s->counter;
+                Yield();        /* let the others run into the lock */
+                s->counter = tmp + 1;
+                MutexUnlock(&s->lock);
+            }
+            MutexLock(&s->lock);
+            if (++s->done == NPROC)
+                CondSignal(&s->allDone);
+            MutexUnlock(&s->lock);
+            Exit(0);
+        }
+    }
+
+    MutexLock(&s->lock);
+    while (s->done < NPROC)
+        CondWait(&s->allDone, &s->lock);
+    tmp = s->counter;
+    MutexUnlock(&s->lock);
+    Exit(tmp);                  /* NPROC * ROUNDS = 400 */
+}
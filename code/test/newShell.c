@@ -3,6 +3,62 @@
 //
 #include "syscall.h"
 
+/* Copy the first word of "from" into "to" as the name of a Nachos
+ * executable: with ".noff" on the end.
+ */
+void
+Program(char *to, char *from)
+{
+    while (*from == ' ')
+        from++;
+    while (*from != ' ' && *from != '\0' && *from != '\n')
+        *to++ = *from++;
+    *to++ = '.';
+    *to++ = 'n';
+    *to++ = 'o';
+    *to++ = 'f';
+    *to++ = 'f';
+    *to = '\0';
+}
+
+/* Run "left | right": left's ConsoleOutput goes through a pipe to
+ * right's ConsoleInput.  Exec'd programs get the caller's console
+ * descriptors, so point ours at the pipe ends around each Exec --
+ * Close one and Dup a pipe end into its place -- and put them back.
+ */
+void
+RunPipeline(char *left, char *right)
+{
+    OpenFileId fds[2], saved;
+    SpaceId writer, reader;
+
+    if (Pipe(fds) < 0)
+        return;
+
+    saved = Dup(ConsoleOutput);
+    Close(ConsoleOutput);
+    Dup(fds[1]);                /* the lowest free: ConsoleOutput */
+    writer = Exec(left);
+    Close(ConsoleOutput);
+    Dup(saved);
+    Close(saved);
+    Close(fds[1]);              /* or right never sees the end */
+
+    saved = Dup(ConsoleInput);
+    Close(ConsoleInput);
+    Dup(fds[0]);
+    reader = Exec(right);
+    Close(ConsoleInput);
+    Dup(saved);
+    Close(saved);
+    Close(fds[0]);
+
+    if (writer != -1 && writer != 127)
+        Join(writer);
+    if (reader != -1 && reader != 127)
+        Join(reader);
+}
+
 int
 main()
 {
@@ -12,7 +68,8 @@ main()
     char prompt[7], ch, buffer[60];
     char Hbuffer[80];
     char Cbuffer[80];
-    int i,j,k,h,m;
+    char left[60], right[60];
+    int i,j,k,h,m,bar;
     char c;
 
     prompt[0] = 'N';
@@ -42,6 +99,17 @@ main()
 
         } while( buffer[i++] != '\n' );
 
+        // cmd1 | cmd2: two programs, joined by a pipe
+        for (bar = 0; bar < i && buffer[bar] != '|'; bar++)
+            ;
+        if (bar < i) {
+            buffer[bar] = '\0';
+            Program(left, buffer);
+            Program(right, &buffer[bar + 1]);
+            RunPipeline(left, right);
+            continue;
+        }
+
         Hbuffer[--h] = '\0';
 
 
@@ -0,0 +1,69 @@
+/* psort.c
+ *	Parallel version of sort.c: the array lives in a shared memory
+ *	segment, and NPROC forked children each bubble sort a slice of
+ *	it in place.  Once they have all been Joined, the parent merges
+ *	the sorted slices.  No data goes through a syscall.
+ */
+
+#include "syscall.h"
+
+#define ARRAYSIZE 1024
+#define NPROC 4
+#define SLICE (ARRAYSIZE / NPROC)
+#define KEY 42
+
+int B[ARRAYSIZE];           /* the merged result: the parent's own */
+
+void
+SortSlice(int *a) {
+    int i, j, tmp;
+
+    for (i = 0; i < (SLICE - 1); i++)
+        for (j = 0; j < ((SLICE - 1) - i); j++)
+            if (a[j] > a[j + 1]) {
+                tmp = a[j];
+                a[j] = a[j + 1];
+                a[j + 1] = tmp;
+            }
+}
+
+int
+main() {
+    int *A;
+    SpaceId pid[NPROC];
+    int next[NPROC];
+    int i, p, best;
+
+    A = (int *) ShmCreate(KEY, ARRAYSIZE * sizeof(int));
+    if (A == (int *) -1)
+        Exit(-1);
+    for (i = 0; i < ARRAYSIZE; i++)     /* reverse sorted order */
+        A[i] = ARRAYSIZE - i - 1;
+
+    for (p = 0; p < NPROC; p++) {
+        pid[p] = Fork();        /* the child shares A, at the same place */
+        if (pid[p] == 0) {
+            SortSlice(A + p * SLICE);
+            Exit(0);
+        }
+    }
+    for (p = 0; p < NPROC; p++) {
+        Join(pid[p]);
+        next[p] = p * SLICE;
+    }
+
+    for (i = 0; i < ARRAYSIZE; i++) {   /* merge the slices */
+        best = -1;
+        for (p = 0; p < NPROC; p++)
+            if (next[p] < (p + 1) * SLICE &&
+                (best == -1 || A[next[p]] < A[next[best]]))
+                best = p;
+        B[i] = A[next[best]++];
+    }
+    ShmDetach((char *) A);      /* the segment goes with the last user */
+
+    for (i = 0; i < ARRAYSIZE; i++)
+        if (B[i] != i)
+            Exit(1);
+    Exit(B[0]);                 /* should be 0! */
+}
@@ -1,12 +1,63 @@
 #include "syscall.h"
 
+/* Run "left | right": left's ConsoleOutput goes through a pipe to
+ * right's ConsoleInput.  Exec'd programs get the caller's console
+ * descriptors, so point ours at the pipe ends around each Exec --
+ * Close one and Dup a pipe end into its place -- and put them back.
+ */
+void
+RunPipeline(char *left, char *right) {
+    OpenFileId fds[2], saved;
+    SpaceId writer, reader;
+
+    if (Pipe(fds) < 0)
+        return;
+
+    saved = Dup(ConsoleOutput);
+    Close(ConsoleOutput);
+    Dup(fds[1]);                /* the lowest free: ConsoleOutput */
+    writer = Exec(left);
+    Close(ConsoleOutput);
+    Dup(saved);
+    Close(saved);
+    Close(fds[1]);              /* or right never sees the end */
+
+    saved = Dup(ConsoleInput);
+    Close(ConsoleInput);
+    Dup(fds[0]);
+    reader = Exec(right);
+    Close(ConsoleInput);
+    Dup(saved);
+    Close(saved);
+    Close(fds[0]);
+
+    if (writer != -1)
+        Join(writer);
+    if (reader != -1)
+        Join(reader);
+}
+
+/* Return "s" without its leading and trailing blanks. */
+char *
+Trim(char *s) {
+    char *end;
+
+    while (*s == ' ')
+        s++;
+    for (end = s; *end != '\0'; end++)
+        ;
+    while (end > s && end[-1] == ' ')
+        *--end = '\0';
+    return s;
+}
+
 int
 main() {
     SpaceId newProc;
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
     char prompt[2], ch, buffer[60];
-    int i;
+    int i, bar;
 
     prompt[0] = '-';
     prompt[1] = '-';
@@ -24,7 +75,12 @@ main() {
 
         buffer[--i] = '\0';
 
-        if (i > 0) {
+        for (bar = 0; bar < i && buffer[bar] != '|'; bar++)
+            ;
+        if (bar < i) {              /* cmd1 | cmd2 */
+            buffer[bar] = '\0';
+            RunPipeline(Trim(buffer), Trim(&buffer[bar + 1]));
+        } else if (i > 0) {
             newProc = Exec(buffer);
             Join(newProc);
         }
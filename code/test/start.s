@@ -137,6 +137,158 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl ProcStat
+	.ent	ProcStat
+ProcStat:
+	addiu $2,$0,SC_ProcStat
+	syscall
+	j	$31
+	.end ProcStat
+
+	.globl MemStat
+	.ent	MemStat
+MemStat:
+	addiu $2,$0,SC_MemStat
+	syscall
+	j	$31
+	.end MemStat
+
+	.globl Mmap
+	.ent	Mmap
+Mmap:
+	addiu $2,$0,SC_Mmap
+	syscall
+	j	$31
+	.end Mmap
+
+	.globl Munmap
+	.ent	Munmap
+Munmap:
+	addiu $2,$0,SC_Munmap
+	syscall
+	j	$31
+	.end Munmap
+
+	.globl ReadV
+	.ent	ReadV
+ReadV:
+	addiu $2,$0,SC_ReadV
+	syscall
+	j	$31
+	.end ReadV
+
+	.globl WriteV
+	.ent	WriteV
+WriteV:
+	addiu $2,$0,SC_WriteV
+	syscall
+	j	$31
+	.end WriteV
+
+	.globl Pipe
+	.ent	Pipe
+Pipe:
+	addiu $2,$0,SC_Pipe
+	syscall
+	j	$31
+	.end Pipe
+
+	.globl Dup
+	.ent	Dup
+Dup:
+	addiu $2,$0,SC_Dup
+	syscall
+	j	$31
+	.end Dup
+
+	.globl ShmCreate
+	.ent	ShmCreate
+ShmCreate:
+	addiu $2,$0,SC_ShmCreate
+	syscall
+	j	$31
+	.end ShmCreate
+
+	.globl ShmAttach
+	.ent	ShmAttach
+ShmAttach:
+	addiu $2,$0,SC_ShmAttach
+	syscall
+	j	$31
+	.end ShmAttach
+
+	.globl ShmDetach
+	.ent	ShmDetach
+ShmDetach:
+	addiu $2,$0,SC_ShmDetach
+	syscall
+	j	$31
+	.end ShmDetach
+
+	.globl FutexWait
+	.ent	FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	j	$31
+	.end FutexWait
+
+	.globl FutexWake
+	.ent	FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	j	$31
+	.end FutexWake
+
+	.globl Sbrk
+	.ent	Sbrk
+Sbrk:
+	addiu $2,$0,SC_Sbrk
+	syscall
+	j	$31
+	.end Sbrk
+
+/* -------------------------------------------------------------
+ * CompareAndSwap
+ *	Not a system call: swap "value" ($6) into the word at "addr"
+ *	($4) if it holds "old" ($5), and return what it held.  LL and
+ *	SC are MIPS II instructions, which the assembler may not take
+ *	for an R2000, so they are spelled out:
+ *
+ *		0xc0820000	ll	$2,0($4)
+ *		0xe0830000	sc	$3,0($4)
+ *
+ *	An SC that finds the word may have changed since the LL (another
+ *	thread ran in between) stores nothing and leaves 0 in $3, and
+ *	the whole thing is tried again.
+ * -------------------------------------------------------------
+ */
+
+	.globl CompareAndSwap
+	.ent	CompareAndSwap
+CompareAndSwap:
+	.set	noreorder
+1:	.word	0xc0820000	/* ll $2,0($4) */
+	nop			/* load delay */
+	bne	$2,$5,2f
+	move	$3,$6		/* (delay slot) */
+	.word	0xe0830000	/* sc $3,0($4) */
+	beq	$3,$0,1b
+	nop
+2:	j	$31
+	nop
+	.set	reorder
+	.end CompareAndSwap
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -0,0 +1,20 @@
+/* upper.c
+ *	Copy ConsoleInput to ConsoleOutput in capitals, until the end of
+ *	the input -- a filter for the end of a shell pipeline, as in
+ *	"hello | upper".
+ */
+
+#include "syscall.h"
+
+int main() {
+    char buf[64];
+    int n, i;
+
+    while ((n = Read(buf, 64, ConsoleInput)) > 0) {
+        for (i = 0; i < n; i++)
+            if (buf[i] >= 'a' && buf[i] <= 'z')
+                buf[i] -= 'a' - 'A';
+        Write(buf, n, ConsoleOutput);
+    }
+    Exit(0);
+}
@@ -0,0 +1,117 @@
+/* usync.h
+ *	Mutexes and condition variables for user programs, kept in memory
+ *	the processes using them share (see ShmCreate), on top of
+ *	CompareAndSwap and the FutexWait/FutexWake syscalls.
+ *
+ *	Taking a free mutex and releasing one nobody is waiting for are
+ *	done entirely in user mode: no syscall at all.  A process that
+ *	finds the mutex held spins for a little while, in case it is
+ *	released soon, before asking the kernel to put it to sleep.
+ *
+ *	A mutex word is 0 (free), 1 (held), or 2 (held, and somebody may
+ *	be asleep waiting for it), as in Drepper's "Futexes Are Tricky".
+ *
+ *	Since test/Makefile builds each program from a single .c file,
+ *	this is a header of static functions: #include it in the program.
+ */
+
+#ifndef USYNC_H
+#define USYNC_H
+
+#include "syscall.h"
+
+#define MutexSpins 50           /* tries before sleeping */
+
+typedef struct {
+    volatile int state;         /* 0, 1 or 2, as above */
+} Mutex;
+
+typedef struct {
+    volatile int seq;           /* bumped by every Signal and Broadcast */
+    volatile int waiters;       /* processes in CondWait */
+} Cond;
+
+/* Store "value" in the word at "addr", and return what it held. */
+static int
+AtomicExchange(volatile int *addr, int value) {
+    int old;
+
+    do
+        old = *addr;
+    while (CompareAndSwap((int *) addr, old, value) != old);
+    return old;
+}
+
+static void
+MutexInit(Mutex *m) {
+    m->state = 0;
+}
+
+static void
+MutexLock(Mutex *m) {
+    int c, i;
+
+    c = CompareAndSwap((int *) &m->state, 0, 1);
+    if (c == 0)
+        return;                 /* it was free: the fast path */
+    for (i = 0; i < MutexSpins; i++) {
+        if (m->state == 0) {
+            c = CompareAndSwap((int *) &m->state, 0, 1);
+            if (c == 0)
+                return;
+        }
+    }
+    /* Sleep until it is free, marking it as having waiters, so that
+     * whoever releases it wakes one. */
+    if (c != 2)
+        c = AtomicExchange(&m->state, 2);
+    while (c != 0) {
+        FutexWait((int *) &m->state, 2);
+        c = AtomicExchange(&m->state, 2);
+    }
+}
+
+static void
+MutexUnlock(Mutex *m) {
+    if (AtomicExchange(&m->state, 0) == 2)  /* somebody may be asleep */
+        FutexWake((int *) &m->state, 1);
+}
+
+static void
+CondInit(Cond *c) {
+    c->seq = 0;
+    c->waiters = 0;
+}
+
+/* Release "m", wait for a Signal or Broadcast, and take "m" again.  As
+ * with any condition variable, check the condition again afterwards. */
+static void
+CondWait(Cond *c, Mutex *m) {
+    int seq = c->seq;
+
+    c->waiters++;
+    MutexUnlock(m);
+    FutexWait((int *) &c->seq, seq);    /* returns at once if signalled */
+    MutexLock(m);                       /* already */
+    c->waiters--;
+}
+
+/* Wake one waiter (Signal) or all of them (Broadcast).  Hold the mutex
+ * CondWait was given; with nobody waiting, no syscall is made. */
+static void
+CondSignal(Cond *c) {
+    if (c->waiters > 0) {
+        c->seq++;
+        FutexWake((int *) &c->seq, 1);
+    }
+}
+
+static void
+CondBroadcast(Cond *c) {
+    if (c->waiters > 0) {
+        c->seq++;
+        FutexWake((int *) &c->seq, c->waiters);
+    }
+}
+
+#endif /* USYNC_H */
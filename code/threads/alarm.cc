@@ -0,0 +1,139 @@
+// alarm.cc
+//	Routines to implement the kernel alarm clock.
+//
+//	Sleepers are kept on a List sorted by wakeup time.  At most one
+//	alarm interrupt is kept outstanding for the head of the list;
+//	a new sleeper that wants to wake up sooner schedules another
+//	one.  A stale interrupt (one for a time with no sleepers left)
+//	is harmless -- the handler just finds nothing to do.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AlarmHandler
+// 	Interrupt handler for the alarm.  Called with interrupts
+//	disabled, when simulated time reaches a scheduled wakeup.
+//
+//	"arg" is the Alarm that scheduled the interrupt.
+//----------------------------------------------------------------------
+
+static void
+AlarmHandler(_int arg) {
+    Alarm *alarm = (Alarm *) arg;
+
+    alarm->CallBack();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock, with no one sleeping.
+//----------------------------------------------------------------------
+
+Alarm::Alarm() {
+    sleepers = new List;
+    nextWakeup = -1;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the alarm clock.  Any thread still asleep on it
+//	is simply abandoned, as with a semaphore.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm() {
+    delete sleepers;
+}
+
+//----------------------------------------------------------------------
+// Alarm::ScheduleWakeup
+// 	If the earliest sleeper wants to wake up before the outstanding
+//	alarm interrupt (or there is none), ask for a new interrupt.
+//
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::ScheduleWakeup() {
+    ListElement *first = sleepers->getFirst();
+    int when;
+
+    if (first == NULL)
+        return;
+    when = first->key;
+    if (nextWakeup != -1 && nextWakeup <= when)
+        return;                 // already covered
+    if (when <= stats->totalTicks)
+        when = stats->totalTicks + 1;
+    DEBUG('t', "Alarm interrupt scheduled for time %d\n", when);
+    interrupt->Schedule(AlarmHandler, (_int) this,
+                        when - stats->totalTicks, AlarmInt);
+    nextWakeup = when;
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until simulated time reaches
+//	"when".  Returns immediately if that time has already passed.
+//
+//	The thread may run a little later than "when", since the
+//	interrupt is only checked on the next tick, and then the woken
+//	thread has to wait its turn on the ready list.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (when > stats->totalTicks) {
+        DEBUG('t', "Thread \"%s\" sleeping until time %d\n",
+              currentThread->getName(), when);
+        sleepers->SortedInsert((void *) currentThread, when);
+        ScheduleWakeup();
+        currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Pause
+// 	Put the current thread to sleep for "howLong" ticks.
+//----------------------------------------------------------------------
+
+void
+Alarm::Pause(int howLong) {
+    if (howLong > 0)
+        WaitUntil(stats->totalTicks + howLong);
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	An alarm interrupt has fired.  Wake up every thread whose
+//	wakeup time has arrived, and arrange for an interrupt for the
+//	next sleeper, if any.
+//
+//	Called from the interrupt handler, with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack() {
+    ListElement *first;
+    Thread *thread;
+    int when;
+
+    if (nextWakeup != -1 && nextWakeup <= stats->totalTicks)
+        nextWakeup = -1;        // this was the outstanding interrupt
+    while ((first = sleepers->getFirst()) != NULL
+           && first->key <= stats->totalTicks) {
+        thread = (Thread *) sleepers->SortedRemove(&when);
+        DEBUG('t', "Waking up thread \"%s\" (due %d) at time %d\n",
+              thread->getName(), when, stats->totalTicks);
+        scheduler->ReadyToRun(thread);
+    }
+    ScheduleWakeup();
+}
@@ -0,0 +1,50 @@
+// alarm.h 
+//	Data structures for a kernel alarm clock.
+//
+//	A thread that wants to wait for some amount of simulated time
+//	calls Alarm::WaitUntil (or Pause) and is put to sleep on a list
+//	of sleepers, sorted by wakeup time.  Rather than having the
+//	thread spin in a Yield loop, the alarm asks the interrupt
+//	simulator for a one-shot interrupt at the earliest wakeup time;
+//	the interrupt handler then puts every thread whose time has come
+//	back on the ready list.
+//
+//	Because the sleepers are blocked, an otherwise idle machine
+//	simply fast-forwards the clock to the next wakeup (see
+//	Interrupt::Idle) instead of burning system ticks.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "list.h"
+
+// The following class defines the kernel alarm clock.
+
+class Alarm {
+public:
+    Alarm();                    // initialize with no sleepers
+    ~Alarm();                   // assume no one is still sleeping
+
+    void WaitUntil(int when);   // sleep until totalTicks >= "when"
+    void Pause(int howLong);    // sleep for "howLong" ticks
+
+    void CallBack();            // called from the interrupt handler:
+    // wake up every sleeper that is due
+
+    int NumSleepers() { return sleepers->ListLength(); }
+
+private:
+    List *sleepers;             // sleeping threads, sorted by wakeup time
+    int nextWakeup;             // time of the earliest alarm interrupt
+    // still outstanding, or -1 if none
+
+    void ScheduleWakeup();      // make sure an interrupt is due at
+    // the earliest sleeper's wakeup time
+};
+
+#endif // ALARM_H
@@ -8,23 +8,53 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -trace <trace file>
+//		-s -x <nachos file> -c <consoleIn> <consoleOut> -pb
+//		-ps <page size> -pipeb
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -e <network orderability>
 //              -m <machine id>
 //              -o <other machine id>
-//              -z
+//              -z -sb -bt -vr <replacement policy> -vf <frames> -vz <zones>
+//              -vp <pages> -vg
+//              -tlb <entries> -tlbw <ways> -tlbr <TLB replacement policy>
+//              -sp
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -trace writes a Chrome trace-event (JSON) timeline of context
+//       switches, interrupts, disk requests and syscalls to <trace file>
 //    -z prints the copyright message
+//    -sb (first flag only) runs the context switch benchmark instead
+//       of ThreadTest
+//    -bt (first flag only) tests barriers and latches instead of
+//       ThreadTest
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
 //    -c tests the console
+//    -pb compares the page table layout built in with a linear table
+//    -ps sets the page size in bytes: a power of two, at least a disk
+//       sector (default 4096)
+//    -pipeb measures pipe bandwidth, for a range of transfer sizes
+//
+//  VM
+//    -vr sets the page replacement policy: fifo (the default), clock,
+//       eclock or wsclock
+//    -vf sets how many physical page frames user programs may use
+//    -vz splits the frames into that many allocation zones (default 1)
+//    -vp sets the most pages fetched ahead of a sequential page fault
+//       (default 8; 0 turns fetching ahead off)
+//    -vg replaces pages globally, with no per-process frame limits
+//       (by default, a page-fault-frequency controller sets them)
+//    -tlb sets the number of TLB entries (with USE_TLB)
+//    -tlbw sets the TLB's associativity (default: fully associative)
+//    -tlbr sets the TLB replacement policy: random (the default), fifo
+//       or lru
+//    -sp maps runs of SuperPageSpan pages with one TLB entry where it
+//       can (with USE_TLB)
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -60,16 +90,18 @@
 
 // External functions used by this file
 
-extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
+extern void ThreadTest(void), SwitchBench(void);
+extern void Copy(char *unixFile, char *nachosFile);
 
 extern void Print(char *file), PerformanceTest(void);
 
 
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
+extern void PageTableBench(void), PipeBench(void);
 
 extern void MailTest(int networkID);
 
-extern void SynchTest(void);
+extern void SynchTest(void), BarrierTest(void);
 
 //----------------------------------------------------------------------
 // main
@@ -96,7 +128,12 @@ main(int argc, char **argv) {
     (void) Initialize(argc, argv);    //system.cc
 
 #ifdef THREADS
-    ThreadTest();
+    if (argc > 1 && !strcmp(argv[1], "-sb"))
+        SwitchBench();          // time context switches instead
+    else if (argc > 1 && !strcmp(argv[1], "-bt"))
+        BarrierTest();
+    else
+        ThreadTest();
 #if 0
     SynchTest();
 #endif
@@ -122,6 +159,10 @@ main(int argc, char **argv) {
             interrupt->Halt();        // once we start the console, then
             // Nachos will loop forever waiting
             // for console input
+        } else if (!strcmp(*argv, "-pb")) {     // page table benchmark
+            PageTableBench();
+        } else if (!strcmp(*argv, "-pipeb")) {  // pipe benchmark
+            PipeBench();
         }
 #endif // USER_PROGRAM
 #ifdef FILESYS
@@ -0,0 +1,431 @@
+// ringbuf.cc
+//	Routines to implement lock-free ring buffers and the blocking
+//	wrapper around them.
+//
+//	The blocking wrapper relies on Nachos running one thread at a
+//	time: a thread is only switched out at an interrupt or when it
+//	blocks, so the check "is the ring still full?" and going to sleep
+//	on the semaphore are made atomic just by turning interrupts off.
+//	Waking a waiter is the other side's job, and is only done if the
+//	waiter count says someone is actually asleep.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "ringbuf.h"
+#include "synch.h"
+#include "system.h"
+
+#define RingMaxBatch    32      // most items RingBenchmark moves at once
+
+//----------------------------------------------------------------------
+// RoundUpPow2
+// 	Return the smallest power of two >= n.
+//----------------------------------------------------------------------
+
+static int
+RoundUpPow2(int n) {
+    int p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+//----------------------------------------------------------------------
+// SPSCRing::SPSCRing
+// 	Initialize an empty single-producer, single-consumer ring.
+//
+//	"sz" -- minimum number of items the ring can hold
+//----------------------------------------------------------------------
+
+SPSCRing::SPSCRing(int sz) {
+    ASSERT(sz > 0);
+    size = RoundUpPow2(sz);
+    mask = size - 1;
+    buffer = new void *[size];
+    head = tail = 0;
+}
+
+SPSCRing::~SPSCRing() {
+    delete[] buffer;
+}
+
+//----------------------------------------------------------------------
+// SPSCRing::Put, SPSCRing::Get
+// 	Move one item in or out, returning FALSE instead of waiting if
+//	the ring is full (empty).  Only the producer calls Put, only the
+//	consumer calls Get.
+//----------------------------------------------------------------------
+
+bool
+SPSCRing::Put(void *item) {
+    return PutMany(&item, 1) == 1;
+}
+
+bool
+SPSCRing::Get(void **item) {
+    return GetMany(item, 1) == 1;
+}
+
+//----------------------------------------------------------------------
+// SPSCRing::PutMany
+// 	Copy as many of the n items as fit, then publish them all with a
+//	single update of "head".
+//----------------------------------------------------------------------
+
+int
+SPSCRing::PutMany(void **items, int n) {
+    unsigned h = head;
+    int room = size - (int) (h - tail);
+    int i;
+
+    if (n > room)
+        n = room;
+    for (i = 0; i < n; i++)
+        buffer[(h + i) & mask] = items[i];
+    RingBarrier();              // items are in before the consumer looks
+    head = h + n;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SPSCRing::GetMany
+// 	Take up to n items, then release all their slots with a single
+//	update of "tail".
+//----------------------------------------------------------------------
+
+int
+SPSCRing::GetMany(void **items, int n) {
+    unsigned t = tail;
+    int avail = (int) (head - t);
+    int i;
+
+    if (n > avail)
+        n = avail;
+    for (i = 0; i < n; i++)
+        items[i] = buffer[(t + i) & mask];
+    RingBarrier();              // items are read before the slots are reused
+    tail = t + n;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// MPMCRing::MPMCRing
+// 	Initialize an empty multi-producer, multi-consumer ring.  Cell i
+//	starts out free for the producer at position i.
+//
+//	"sz" -- minimum number of items the ring can hold
+//----------------------------------------------------------------------
+
+MPMCRing::MPMCRing(int sz) {
+    ASSERT(sz > 0);
+    size = RoundUpPow2(sz);
+    mask = size - 1;
+    cells = new RingCell[size];
+    for (int i = 0; i < size; i++) {
+        cells[i].seq = i;
+        cells[i].data = NULL;
+    }
+    enqueuePos = dequeuePos = 0;
+}
+
+MPMCRing::~MPMCRing() {
+    delete[] cells;
+}
+
+//----------------------------------------------------------------------
+// MPMCRing::Put
+// 	Claim the next position by compare-and-swap, fill its cell, then
+//	mark the cell full for the consumer at that position.  If the
+//	cell still holds an item from the previous lap, the ring is full.
+//----------------------------------------------------------------------
+
+bool
+MPMCRing::Put(void *item) {
+    RingCell *cell;
+    unsigned pos = enqueuePos;
+
+    for (;;) {
+        cell = &cells[pos & mask];
+        int dif = (int) (cell->seq - pos);
+        if (dif == 0) {
+            if (__sync_bool_compare_and_swap(&enqueuePos, pos, pos + 1))
+                break;                  // the cell is ours
+        } else if (dif < 0)
+            return FALSE;               // full
+        pos = enqueuePos;               // somebody beat us; try again
+    }
+    cell->data = item;
+    RingBarrier();
+    cell->seq = pos + 1;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MPMCRing::Get
+// 	Claim the next position by compare-and-swap, take its item, then
+//	mark the cell free for the producer one lap later.
+//----------------------------------------------------------------------
+
+bool
+MPMCRing::Get(void **item) {
+    RingCell *cell;
+    unsigned pos = dequeuePos;
+
+    for (;;) {
+        cell = &cells[pos & mask];
+        int dif = (int) (cell->seq - (pos + 1));
+        if (dif == 0) {
+            if (__sync_bool_compare_and_swap(&dequeuePos, pos, pos + 1))
+                break;
+        } else if (dif < 0)
+            return FALSE;               // empty
+        pos = dequeuePos;
+    }
+    *item = cell->data;
+    RingBarrier();
+    cell->seq = pos + mask + 1;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MPMCRing::PutMany, MPMCRing::GetMany
+// 	Move up to n items, stopping at the first full (empty) cell.
+//	Other producers (consumers) may interleave with the batch.
+//----------------------------------------------------------------------
+
+int
+MPMCRing::PutMany(void **items, int n) {
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (!Put(items[i]))
+            break;
+    return i;
+}
+
+int
+MPMCRing::GetMany(void **items, int n) {
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (!Get(&items[i]))
+            break;
+    return i;
+}
+
+bool
+MPMCRing::Full() {
+    unsigned pos = enqueuePos;
+
+    return (int) (cells[pos & mask].seq - pos) < 0;
+}
+
+bool
+MPMCRing::Empty() {
+    unsigned pos = dequeuePos;
+
+    return (int) (cells[pos & mask].seq - (pos + 1)) < 0;
+}
+
+//----------------------------------------------------------------------
+// BlockingRing::BlockingRing
+// 	Initialize a ring that producers and consumers can wait on.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"sz" -- minimum number of items the ring can hold
+//	"multi" -- TRUE if there may be several producers or consumers
+//----------------------------------------------------------------------
+
+BlockingRing::BlockingRing(char *debugName, int sz, bool multi) {
+    name = debugName;
+    spsc = NULL;
+    mpmc = NULL;
+    if (multi)
+        mpmc = new MPMCRing(sz);
+    else
+        spsc = new SPSCRing(sz);
+    notFull = new Semaphore("ring not full", 0);
+    notEmpty = new Semaphore("ring not empty", 0);
+    putWaiters = getWaiters = 0;
+    blocked = 0;
+}
+
+BlockingRing::~BlockingRing() {
+    ASSERT(putWaiters == 0 && getWaiters == 0);
+    delete spsc;
+    delete mpmc;
+    delete notFull;
+    delete notEmpty;
+}
+
+int
+BlockingRing::TryPut(void **items, int n) {
+    return (spsc != NULL) ? spsc->PutMany(items, n) : mpmc->PutMany(items, n);
+}
+
+int
+BlockingRing::TryGet(void **items, int n) {
+    return (spsc != NULL) ? spsc->GetMany(items, n) : mpmc->GetMany(items, n);
+}
+
+bool
+BlockingRing::Full() {
+    return (spsc != NULL) ? spsc->Full() : mpmc->Full();
+}
+
+bool
+BlockingRing::Empty() {
+    return (spsc != NULL) ? spsc->Empty() : mpmc->Empty();
+}
+
+//----------------------------------------------------------------------
+// BlockingRing::PutMany
+// 	Put all n items, sleeping whenever the ring fills up.  After each
+//	chunk goes in, wake as many sleeping consumers as there are new
+//	items -- and none at all if nobody is asleep.
+//----------------------------------------------------------------------
+
+void
+BlockingRing::PutMany(void **items, int n) {
+    int done = 0;
+    IntStatus oldLevel;
+
+    while (done < n) {
+        int k = TryPut(items + done, n - done);
+        done += k;
+        for (; k > 0 && getWaiters > 0; k--) {
+            getWaiters--;
+            notEmpty->V();
+        }
+        if (done < n) {
+            oldLevel = interrupt->SetLevel(IntOff);
+            if (Full()) {           // no consumer got in since TryPut
+                putWaiters++;
+                blocked++;
+                notFull->P();
+            }
+            (void) interrupt->SetLevel(oldLevel);
+        }
+    }
+}
+
+void
+BlockingRing::Put(void *item) {
+    PutMany(&item, 1);
+}
+
+//----------------------------------------------------------------------
+// BlockingRing::GetMany
+// 	Take up to n items, sleeping until there is at least one.  Wake
+//	one sleeping producer for each slot freed.
+//----------------------------------------------------------------------
+
+int
+BlockingRing::GetMany(void **items, int n) {
+    int got;
+    IntStatus oldLevel;
+
+    while ((got = TryGet(items, n)) == 0) {
+        oldLevel = interrupt->SetLevel(IntOff);
+        if (Empty()) {
+            getWaiters++;
+            blocked++;
+            notEmpty->P();
+        }
+        (void) interrupt->SetLevel(oldLevel);
+    }
+    for (int k = got; k > 0 && putWaiters > 0; k--) {
+        putWaiters--;
+        notFull->V();
+    }
+    return got;
+}
+
+void *
+BlockingRing::Get() {
+    void *item;
+
+    (void) GetMany(&item, 1);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RingBenchmark
+// 	Fork nProd producers, each putting perProducer messages into a
+//	BlockingRing, and nCons consumers that drain them, "batch" items
+//	per call.  Every message is a distinct non-zero number, so the
+//	consumers can check that each arrived exactly once.  Returns the
+//	simulated ticks from the first fork until the last consumer is
+//	done; the number of times anyone slept is left in *blocked.
+//----------------------------------------------------------------------
+
+static BlockingRing *benchRing;
+static Semaphore *benchDone;
+static int benchPerProducer, benchPerConsumer, benchBatch;
+static int benchSum;
+
+static void
+RingBenchProducer(_int which) {
+    void *items[RingMaxBatch];
+    int base = which * benchPerProducer;
+    int i, n;
+
+    for (i = 0; i < benchPerProducer; i += n) {
+        n = benchPerProducer - i;
+        if (n > benchBatch)
+            n = benchBatch;
+        for (int j = 0; j < n; j++)
+            items[j] = (void *) (_int) (base + i + j + 1);
+        benchRing->PutMany(items, n);
+    }
+    benchDone->V();
+}
+
+static void
+RingBenchConsumer(_int which) {
+    void *items[RingMaxBatch];
+    int left, n;
+
+    for (left = benchPerConsumer; left > 0; left -= n) {
+        n = benchRing->GetMany(items, (left < benchBatch) ? left : benchBatch);
+        for (int j = 0; j < n; j++)
+            benchSum += (int) (_int) items[j];
+    }
+    benchDone->V();
+}
+
+int
+RingBenchmark(bool multi, int nProd, int nCons, int perProducer, int batch,
+              int *blocked) {
+    int total = nProd * perProducer;
+    int start, i;
+
+    ASSERT(multi || (nProd == 1 && nCons == 1));
+    ASSERT(total % nCons == 0);
+    ASSERT(batch > 0 && batch <= RingMaxBatch);
+
+    benchRing = new BlockingRing("bench ring", 8, multi);
+    benchDone = new Semaphore("bench done", 0);
+    benchPerProducer = perProducer;
+    benchPerConsumer = total / nCons;
+    benchBatch = batch;
+    benchSum = 0;
+
+    start = stats->totalTicks;
+    for (i = 0; i < nProd; i++)
+        (new Thread("ring producer"))->Fork(RingBenchProducer, i);
+    for (i = 0; i < nCons; i++)
+        (new Thread("ring consumer"))->Fork(RingBenchConsumer, i);
+    for (i = 0; i < nProd + nCons; i++)
+        benchDone->P();                 // nobody still touching the ring
+
+    ASSERT(benchSum == total * (total + 1) / 2);
+    *blocked = benchRing->NumBlocked();
+    delete benchRing;
+    delete benchDone;
+    return stats->totalTicks - start;
+}
@@ -0,0 +1,140 @@
+// ringbuf.h
+//	Data structures for lock-free ring buffers, and a blocking wrapper
+//	for use by producer and consumer threads.
+//
+//	SPSCRing is safe for exactly one producer and one consumer; each
+//	index is written by only one side.  MPMCRing allows any number of
+//	producers and consumers: a slot is claimed by compare-and-swap on
+//	the index, and each cell carries a sequence number saying whether
+//	it is ready to be filled or emptied.
+//
+//	Neither ring disables interrupts or touches a semaphore.  The
+//	indices are padded out to separate cache lines so that producers
+//	and consumers do not fight over the same line.
+//
+//	BlockingRing puts one of the two rings behind Put/Get calls that
+//	wait when the ring is full or empty, but only go near a semaphore
+//	when that actually happens.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Semaphore;
+
+#define CacheLineSize   64
+
+// Order the stores to a cell before the store that publishes it.
+#define RingBarrier()   __sync_synchronize()
+
+// The following class defines a single-producer, single-consumer ring.
+// The size is rounded up to a power of two; "head" and "tail" run
+// freely and are masked on use, so head - tail is the number of items.
+
+class SPSCRing {
+public:
+    SPSCRing(int sz);        // initialize an empty ring of >= sz slots
+    ~SPSCRing();
+
+    bool Put(void *item);    // FALSE if the ring is full
+    bool Get(void **item);   // FALSE if the ring is empty
+    int PutMany(void **items, int n);    // put up to n, return how many
+    int GetMany(void **items, int n);    // get up to n, return how many
+
+    bool Full() { return head - tail == (unsigned) size; }
+    bool Empty() { return head == tail; }
+    int Size() { return size; }
+
+private:
+    int size;                // number of slots, a power of two
+    unsigned mask;           // size - 1
+    void **buffer;
+    char pad0[CacheLineSize];
+    volatile unsigned head;  // next slot to fill; written by the producer
+    char pad1[CacheLineSize - sizeof(unsigned)];
+    volatile unsigned tail;  // next slot to empty; written by the consumer
+    char pad2[CacheLineSize - sizeof(unsigned)];
+};
+
+// One cell of an MPMCRing.  "seq" == position means free for the
+// producer at that position; position + 1 means full for the consumer.
+
+class RingCell {
+public:
+    volatile unsigned seq;
+    void *data;
+};
+
+// The following class defines a bounded multi-producer, multi-consumer
+// ring.
+
+class MPMCRing {
+public:
+    MPMCRing(int sz);        // initialize an empty ring of >= sz slots
+    ~MPMCRing();
+
+    bool Put(void *item);    // FALSE if the ring is full
+    bool Get(void **item);   // FALSE if the ring is empty
+    int PutMany(void **items, int n);    // put up to n, return how many
+    int GetMany(void **items, int n);    // get up to n, return how many
+
+    bool Full();             // only a hint when others are running
+    bool Empty();
+    int Size() { return size; }
+
+private:
+    int size;                // number of cells, a power of two
+    unsigned mask;           // size - 1
+    RingCell *cells;
+    char pad0[CacheLineSize];
+    volatile unsigned enqueuePos;   // next position producers claim
+    char pad1[CacheLineSize - sizeof(unsigned)];
+    volatile unsigned dequeuePos;   // next position consumers claim
+    char pad2[CacheLineSize - sizeof(unsigned)];
+};
+
+// The following class defines a ring that producers and consumers can
+// block on.  "multi" selects an MPMCRing; otherwise the caller promises
+// there is only one producer and one consumer.
+
+class BlockingRing {
+public:
+    BlockingRing(char *debugName, int sz, bool multi);
+    ~BlockingRing();
+
+    void Put(void *item);    // wait while the ring is full
+    void *Get();             // wait while the ring is empty
+    void PutMany(void **items, int n);   // wait until all n are in
+    int GetMany(void **items, int n);    // wait for at least one item,
+                                         // return how many were taken
+
+    int NumBlocked() { return blocked; } // times a caller had to sleep
+
+private:
+    char *name;
+    SPSCRing *spsc;          // exactly one of these is non-NULL
+    MPMCRing *mpmc;
+    Semaphore *notFull;      // producers sleep here when the ring is full
+    Semaphore *notEmpty;     // consumers sleep here when it is empty
+    int putWaiters;          // threads asleep on notFull
+    int getWaiters;          // threads asleep on notEmpty
+    int blocked;
+
+    int TryPut(void **items, int n);
+    int TryGet(void **items, int n);
+    bool Full();
+    bool Empty();
+};
+
+// Push nProd * perProducer messages through a BlockingRing, moving
+// "batch" at a time, and return the simulated ticks it took.
+extern int RingBenchmark(bool multi, int nProd, int nCons,
+                         int perProducer, int batch, int *blocked);
+
+#endif // RINGBUF_H
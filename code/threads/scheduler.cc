@@ -21,6 +21,7 @@
 #include "copyright.h"
 #include "scheduler.h"
 #include "system.h"
+#include "trace.h"
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
@@ -29,12 +30,14 @@
 
 Scheduler::Scheduler() {
     readyList = new List;
+    allThreads = new List;
 #ifdef USER_PROGRAM
     // lab78: 如果 joinee 没有退出，joiner 进入等待
     waitingList = new List;
     // lab78: 线程调用了 Finish() 后进入这个状态
     //  Joiner 通过检查这个队列，确定 Joinee 是否已经退出
     terminatedList = new List;
+    userRegsOwner = NULL;
 #endif
 }
 
@@ -45,6 +48,7 @@ Scheduler::Scheduler() {
 
 Scheduler::~Scheduler() {
     delete readyList;
+    delete allThreads;
 }
 
 //----------------------------------------------------------------------
@@ -59,6 +63,7 @@ void
 Scheduler::ReadyToRun(Thread *thread) {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    thread->AccountReady();
     thread->setStatus(READY);
     readyList->Append((void *) thread);
 }
@@ -97,13 +102,25 @@ Scheduler::Run(Thread *nextThread) {
 #ifdef USER_PROGRAM            // ignore until running user programs
     if (currentThread->space != NULL) {    // if this thread is a user program,
         currentThread->SaveUserState(); // save the user's CPU registers
-        currentThread->space->SaveState();
+        userRegsOwner = currentThread;
+        if (nextThread->space != currentThread->space)
+            currentThread->space->SaveState();  // else it stays loaded
     }
 #endif
 
     oldThread->CheckOverflow();            // check if the old thread
     // had an undetected stack overflow
 
+    // charge the old thread for its CPU time, and the new one for
+    // its time on the ready list
+    oldThread->AccountSwitchOut(interrupt->getPreempting());
+    interrupt->setPreempting(FALSE);
+    nextThread->AccountDispatch();
+    TRACE('E', "sched", oldThread->getName(), TracePidThreads,
+          oldThread->getThreadId());
+    TRACE('B', "sched", nextThread->getName(), TracePidThreads,
+          nextThread->getThreadId());
+
     currentThread = nextThread;            // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
 
@@ -129,9 +146,16 @@ Scheduler::Run(Thread *nextThread) {
     }
 
 #ifdef USER_PROGRAM
+    // Fast path: if only kernel threads ran since this thread saved its
+    // user registers, the machine still holds them; and if the last
+    // address space loaded was this one, there is nothing to reload.
+    // Any thread that runs user code saves on its way out, and so takes
+    // over userRegsOwner.
     if (currentThread->space != NULL) {        // if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
-        currentThread->space->RestoreState();
+        if (currentThread != userRegsOwner)
+            currentThread->RestoreUserState();     // to restore, do it.
+        if (!currentThread->space->IsLoaded())
+            currentThread->space->RestoreState();
     }
 #endif
 }
@@ -192,46 +216,79 @@ void Scheduler::deleteTerminatedThread(int spaceId) {
     }
 }
 
-void Scheduler::PrintThreads() {
-    printf("------------ current --------------\n");
-    Thread *t = currentThread;
-    if (t->space != NULL) {
-        printf("spaceID: %d\n", t->space->getSpaceID());
-    } else {
-        printf("spaceID: NULL; 可能是创始线程\n", t->space->getSpaceID());
-    }
-    printf("------------ current --------------\n");
-    printf("------------- ready ---------------\n");
-    int len = readyList->ListLength();
-    for (int i = 1; i <= len; i++) {
-        Thread *t = (Thread*)readyList->getItem(i);
-        if (t->space != NULL) {
-            printf("spaceID: %d\n", t->space->getSpaceID());
-        } else {
-            printf("spaceID: NULL; 可能是创始线程\n", t->space->getSpaceID());
-        }
-    }
-    printf("------------- ready ---------------\n");
-    printf("----------- terminated ------------\n");
-    len = terminatedList->ListLength();
+//----------------------------------------------------------------------
+// Scheduler::AddThread, Scheduler::RemoveThread
+// 	Keep a list of every thread in the system, so that "ps" can
+//	show threads that are blocked on a synchronization object
+//	(and so are on none of the scheduler's own lists).
+//----------------------------------------------------------------------
+
+void
+Scheduler::AddThread(Thread *thread) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    allThreads->Append((void *) thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+void
+Scheduler::RemoveThread(Thread *thread) {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int len = allThreads->ListLength();
+
     for (int i = 1; i <= len; i++) {
-        Thread *t = (Thread*)readyList->getItem(i);
-        if (t->space != NULL) {
-            printf("spaceID: %d\n", t->space->getSpaceID());
-        } else {
-            printf("spaceID: NULL; 可能是创始线程\n", t->space->getSpaceID());
+        if (allThreads->getItem(i) == (void *) thread) {
+            allThreads->RemoveItem(i);
+            break;
         }
     }
-    printf("----------- terminated ------------\n");
-    printf("------------ waiting --------------\n");
-    len = waitingList->ListLength();
+#ifdef USER_PROGRAM
+    if (thread == userRegsOwner)    // don't mistake a new Thread at the
+        userRegsOwner = NULL;       // same address for this one
+#endif
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// Scheduler::FindUserThread
+// 	Return the thread running user process "spaceId", or NULL if
+//	there is none.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::FindUserThread(int spaceId) {
+    Thread *thread, *found = NULL;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int len = allThreads->ListLength();
+
     for (int i = 1; i <= len; i++) {
-        Thread *t = (Thread*)readyList->getItem(i);
-        if (t->space != NULL) {
-            printf("spaceID: %d\n", t->space->getSpaceID());
-        } else {
-            printf("spaceID: NULL; 可能是创始线程\n", t->space->getSpaceID());
+        thread = (Thread *) allThreads->getItem(i);
+        if (thread->space != NULL && thread->space->getSpaceID() == spaceId) {
+            found = thread;
+            break;
         }
     }
-    printf("------------ waiting --------------\n");
+    (void) interrupt->SetLevel(oldLevel);
+    return found;
+}
+#endif
+
+//----------------------------------------------------------------------
+// Scheduler::PrintThreads
+// 	Print a "ps"-style listing of every thread: its process id (if
+//	it runs a user program), state, CPU time split into user and
+//	system ticks, time spent ready and blocked, context switches
+//	and page faults.
+//----------------------------------------------------------------------
+
+void Scheduler::PrintThreads() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int len = allThreads->ListLength();
+
+    printf(" PID NAME             STATE    USER  SYSTEM   READY BLOCKED"
+           "  VCSW  ICSW PGFLT\n");
+    for (int i = 1; i <= len; i++)
+        ((Thread *) allThreads->getItem(i))->PrintStats();
+    (void) interrupt->SetLevel(oldLevel);
 }
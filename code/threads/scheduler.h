@@ -45,12 +45,24 @@ public:
         // TODO: 没有回收内存的糟糕实现
     }
 
-    void PrintThreads();
+    void AddThread(Thread *thread);     // keep track of every thread,
+    void RemoveThread(Thread *thread);  // whatever list it is on
+
+    void PrintThreads();        // "ps": per-thread CPU accounting
+#ifdef USER_PROGRAM
+    Thread *FindUserThread(int spaceId);    // thread running process
+    // "spaceId", or NULL
+#endif
 private:
     List *readyList;        // queue of threads that are ready to run,
     // but not running
+    List *allThreads;       // every Thread that has not been deleted
     List *waitingList;
     List *terminatedList;
+#ifdef USER_PROGRAM
+    Thread *userRegsOwner;  // thread whose user registers were last
+    // saved from the machine, and so are still in it
+#endif
 };
 
 #endif // SCHEDULER_H
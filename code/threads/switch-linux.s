@@ -76,46 +76,35 @@ ThreadRoot:
 **      4(esp)  ->              thread *t1
 **       (esp)  ->              return address
 **
-** we push the current eax on the stack so that we can use it as
-** a pointer to t1, this decrements esp by 4, so when we use it
-** to reference stuff on the stack, we add 4 to the offset.
+** SWITCH is called like any other function, so only the callee-saved
+** registers (ebx, esi, edi, ebp, esp) and the return address have to
+** be saved for t1; the caller already assumes eax, ecx and edx are
+** lost.  ecx and edx are still loaded for t2, because a thread that
+** has never run gets its StartupPC and InitialArg from them in
+** ThreadRoot.
 */
-        .comm   _eax_save,4
-
         .globl  SWITCH
 SWITCH:
-        movl    %eax,_eax_save          # save the value of eax
         movl    4(%esp),%eax            # move pointer to t1 into eax
-        movl    %ebx,_EBX(%eax)         # save registers
-        movl    %ecx,_ECX(%eax)
-        movl    %edx,_EDX(%eax)
+        movl    %ebx,_EBX(%eax)         # save callee-saved registers
         movl    %esi,_ESI(%eax)
         movl    %edi,_EDI(%eax)
         movl    %ebp,_EBP(%eax)
         movl    %esp,_ESP(%eax)         # save stack pointer
-        movl    _eax_save,%ebx          # get the saved value of eax
-        movl    %ebx,_EAX(%eax)         # store it
         movl    0(%esp),%ebx            # get return address from stack into ebx
         movl    %ebx,_PC(%eax)          # save it into the pc storage
 
         movl    8(%esp),%eax            # move pointer to t2 into eax
 
-        movl    _EAX(%eax),%ebx         # get new value for eax into ebx
-        movl    %ebx,_eax_save          # save it
-        movl    _EBX(%eax),%ebx         # retore old registers
-        movl    _ECX(%eax),%ecx
+        movl    _EBX(%eax),%ebx         # restore registers
+        movl    _ECX(%eax),%ecx         # (only ThreadRoot needs ecx, edx)
         movl    _EDX(%eax),%edx
         movl    _ESI(%eax),%esi
         movl    _EDI(%eax),%edi
         movl    _EBP(%eax),%ebp
         movl    _ESP(%eax),%esp         # restore stack pointer
         movl    _PC(%eax),%eax          # restore return address into eax
-#       movl    %eax,4(%esp)            # copy over the ret address on the stack
-        movl    %eax,0(%esp)    
-	#This is a bug, the offset for return address should be 0, not 4.
-	# -- ptang, Sep/1/03, at UALR
-	
-        movl    _eax_save,%eax
+        movl    %eax,0(%esp)            # copy over the ret address on the stack
 
         ret
 
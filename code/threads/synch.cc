@@ -25,6 +25,10 @@
 #include "synch.h"
 #include "system.h"
 
+// Contention is measured in simulated ticks.  Global primitives can be
+// constructed before "stats" exists, but are not used until after.
+#define SynchNow()  (stats->totalTicks)
+
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
 // 	Initialize a semaphore, so that it can be used for synchronization.
@@ -37,6 +41,7 @@ Semaphore::Semaphore(char *debugName, int initialValue) {
     name = debugName;
     value = initialValue;
     queue = new List;
+    prof = SynchProfileFor("semaphore", name);
 }
 
 //----------------------------------------------------------------------
@@ -62,6 +67,7 @@ Semaphore::~Semaphore() {
 void
 Semaphore::P() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);    // disable interrupts
+    int start = SynchNow();
 
     while (value == 0) {            // semaphore not available
         queue->Append((void *) currentThread);    // so go to sleep
@@ -69,6 +75,8 @@ Semaphore::P() {
     }
     value--;                    // semaphore available,
     // consume its value
+    if (prof != NULL)
+        prof->Acquired(SynchNow() - start);
 
     (void) interrupt->SetLevel(oldLevel);    // re-enable interrupts
 }
@@ -106,6 +114,9 @@ Lock::Lock(char *debugName) {
     name = debugName;
     owner = NULL;
     lock = new Semaphore(name, 1);
+    lock->prof = NULL;          // counted here, as a lock, instead
+    prof = SynchProfileFor("lock", name);
+    acquiredAt = 0;
 }
 
 
@@ -126,9 +137,12 @@ Lock::~Lock() {
 //----------------------------------------------------------------------
 void Lock::Acquire() {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);  // disable interrupts
+    int start = SynchNow();
 
     lock->P();                            // procure the semaphore
     owner = currentThread;                // record the new owner of the lock
+    acquiredAt = SynchNow();
+    prof->Acquired(acquiredAt - start);
     (void) interrupt->SetLevel(oldLevel); // re-enable interrupts
 }
 
@@ -142,6 +156,7 @@ void Lock::Release() {
 
     // Ensure: a) lock is BUSY  b) this thread is the same one that acquired it.
     ASSERT(currentThread == owner);
+    prof->Released(SynchNow() - acquiredAt);
     owner = NULL;                          // clear the owner
     lock->V();                             // vanquish the semaphore
     (void) interrupt->SetLevel(oldLevel);
@@ -171,6 +186,7 @@ Condition::Condition(char *debugName) {
     name = debugName;
     queue = new List;
     lock = NULL;
+    prof = SynchProfileFor("condition", name);
 }
 
 //----------------------------------------------------------------------
@@ -194,6 +210,7 @@ Condition::~Condition() {
 //----------------------------------------------------------------------
 void Condition::Wait(Lock *conditionLock) {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = SynchNow();
 
     ASSERT(conditionLock->isHeldByCurrentThread());  // check pre-condition
     if (queue->IsEmpty()) {
@@ -203,6 +220,7 @@ void Condition::Wait(Lock *conditionLock) {
     queue->Append(currentThread);  // add this thread to the waiting list
     conditionLock->Release();      // release the lock
     currentThread->Sleep();        // goto sleep
+    prof->Acquired(SynchNow() - start);  // time until signalled
     conditionLock->Acquire();      // awaken: re-acquire the lock
     (void) interrupt->SetLevel(oldLevel);
 }
@@ -247,3 +265,259 @@ void Condition::Broadcast(Lock *conditionLock) {
     }
     (void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock to be FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"rwPolicy" is WriterPreferred or ReaderPreferred.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char *debugName, RWPolicy rwPolicy) {
+    name = debugName;
+    policy = rwPolicy;
+    readers = 0;
+    writer = NULL;
+    readQueue = new List;
+    writeQueue = new List;
+    prof = SynchProfileFor("rwlock", name);
+    writeAcquiredAt = 0;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	De-allocate the lock.  Assume no one still holds or waits on it.
+//----------------------------------------------------------------------
+
+RWLock::~RWLock() {
+    delete readQueue;
+    delete writeQueue;
+}
+
+//----------------------------------------------------------------------
+// RWLock::WakeReaders
+//      Hand the lock to every thread waiting in ReadAcquire.  The
+//      reader count is bumped on their behalf, so they own the lock
+//      as soon as they are put on the ready list.
+//
+//      Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+RWLock::WakeReaders() {
+    Thread *thread;
+
+    while ((thread = (Thread *) readQueue->Remove()) != NULL) {
+        readers++;
+        scheduler->ReadyToRun(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadAcquire
+//      Join the readers, unless a writer holds the lock or (for
+//      WriterPreferred) a writer is already waiting for it.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadAcquire() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = SynchNow();
+
+    if (writer == NULL &&
+        (policy == ReaderPreferred || writeQueue->IsEmpty())) {
+        readers++;                      // no conflict, go right in
+    } else {
+        readQueue->Append((void *) currentThread);
+        currentThread->Sleep();         // woken with the lock handed to us
+    }
+    prof->Acquired(SynchNow() - start);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadRelease
+//      Leave the readers; the last one out hands the lock to a
+//      waiting writer.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReadRelease() {
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0 && writer == NULL);
+    readers--;
+    if (readers == 0) {
+        thread = (Thread *) writeQueue->Remove();
+        if (thread != NULL) {
+            writer = thread;
+            scheduler->ReadyToRun(thread);
+        }
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteAcquire
+//      Wait until no one holds the lock, then take it exclusively.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteAcquire() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = SynchNow();
+
+    if (writer == NULL && readers == 0) {
+        writer = currentThread;
+    } else {
+        writeQueue->Append((void *) currentThread);
+        currentThread->Sleep();         // woken with the lock handed to us
+        ASSERT(writer == currentThread);
+    }
+    writeAcquiredAt = SynchNow();
+    prof->Acquired(writeAcquiredAt - start);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteRelease
+//      Give up exclusive access.  Depending on the policy, the lock goes
+//      to the next waiting writer or to all the waiting readers; if
+//      only one kind is waiting, that kind gets it.
+//----------------------------------------------------------------------
+
+void
+RWLock::WriteRelease() {
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(writer == currentThread);
+    prof->Released(SynchNow() - writeAcquiredAt);
+    writer = NULL;
+    if (policy == ReaderPreferred && !readQueue->IsEmpty()) {
+        WakeReaders();
+    } else if ((thread = (Thread *) writeQueue->Remove()) != NULL) {
+        writer = thread;
+        scheduler->ReadyToRun(thread);
+    } else {
+        WakeReaders();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::isWriteHeldByCurrentThread
+//----------------------------------------------------------------------
+
+bool
+RWLock::isWriteHeldByCurrentThread() {
+    bool result;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    result = currentThread == writer;
+    (void) interrupt->SetLevel(oldLevel);
+    return (result);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+// 	Initialize a barrier for "count" threads.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(char *debugName, int count) {
+    ASSERT(count > 0);
+    name = debugName;
+    parties = count;
+    arrived = 0;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Barrier::~Barrier
+//----------------------------------------------------------------------
+
+Barrier::~Barrier() {
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Barrier::Wait
+//      Wait until "parties" threads have called Wait.  The last thread
+//      to arrive wakes the others and resets the barrier for the next
+//      round; it does not block itself.
+//----------------------------------------------------------------------
+
+void
+Barrier::Wait() {
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    arrived++;
+    if (arrived == parties) {
+        arrived = 0;
+        while ((thread = (Thread *) queue->Remove()) != NULL)
+            scheduler->ReadyToRun(thread);
+    } else {
+        queue->Append((void *) currentThread);
+        currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Latch::Latch
+// 	Initialize a countdown latch to "count".
+//----------------------------------------------------------------------
+
+Latch::Latch(char *debugName, int count) {
+    ASSERT(count >= 0);
+    name = debugName;
+    value = count;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Latch::~Latch
+//----------------------------------------------------------------------
+
+Latch::~Latch() {
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Latch::CountDown
+//      Decrement the count; when it reaches zero, release everyone
+//      waiting.  Counting down an open latch is an error.
+//----------------------------------------------------------------------
+
+void
+Latch::CountDown() {
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(value > 0);
+    value--;
+    if (value == 0) {
+        while ((thread = (Thread *) queue->Remove()) != NULL)
+            scheduler->ReadyToRun(thread);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Latch::Wait
+//      Wait until the count reaches zero; return at once if it already has.
+//----------------------------------------------------------------------
+
+void
+Latch::Wait() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (value > 0) {
+        queue->Append((void *) currentThread);
+        currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "synchprof.h"
 
 
 // The following class defines a "semaphore" whose value is a non-negative
@@ -53,6 +54,9 @@ private:
     char *name;        // useful for debugging
     int value;         // semaphore value, always >= 0
     List *queue;       // threads waiting in P() for the value to be > 0
+    SynchProfile *prof;  // contention counters, NULL if not profiled
+
+    friend class Lock;  // a Lock profiles its own semaphore
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -85,6 +89,8 @@ private:
     char *name;                // for debugging
     Thread *owner;                      // remember who acquired the lock
     Semaphore *lock;                    // use semaphore for the actual lock
+    SynchProfile *prof;                 // contention counters
+    int acquiredAt;                     // when "owner" got the lock
 };
 
 // The following class defines a "condition variable".  A condition
@@ -139,6 +145,90 @@ private:
     List *queue;  // threads waiting on the condition
     Lock *lock;   // debugging aid:  used to check correctness of
     // arguments to Wait, Signal and Broacast
+    SynchProfile *prof;  // time spent in Wait
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold the lock at once, but a writer holds it alone:
+//
+//	ReadAcquire -- wait until no writer holds the lock, then join
+//		the readers
+//
+//	WriteAcquire -- wait until no reader or writer holds the lock,
+//		then take it exclusively
+//
+// When the lock is released, ownership is handed off directly to the
+// waiting thread(s), so a woken thread never has to re-check the lock.
+// "policy" decides who is served first when both readers and writers
+// are waiting: WriterPreferred keeps new readers out once a writer is
+// queued (so writers can't starve), ReaderPreferred lets readers in
+// whenever no writer is actually holding the lock.
+
+enum RWPolicy { WriterPreferred, ReaderPreferred };
+
+class RWLock {
+public:
+    RWLock(char *debugName, RWPolicy rwPolicy = WriterPreferred);
+    ~RWLock();                          // deallocate the lock
+    char *getName() { return name; }    // debugging assist
+
+    void ReadAcquire();         // shared access; these four are *atomic*
+    void ReadRelease();
+    void WriteAcquire();        // exclusive access
+    void WriteRelease();
+
+    bool isWriteHeldByCurrentThread();  // true if the current thread
+    // holds the lock for writing
+
+private:
+    char *name;                 // for debugging
+    RWPolicy policy;            // who goes first when both are waiting
+    int readers;                // number of threads holding a read lock
+    Thread *writer;             // thread holding the write lock, or NULL
+    List *readQueue;            // threads waiting in ReadAcquire
+    List *writeQueue;           // threads waiting in WriteAcquire
+    SynchProfile *prof;         // contention counters
+    int writeAcquiredAt;        // when "writer" got the lock
+
+    void WakeReaders();         // hand the lock to every waiting reader
+};
+
+// The following class defines a "barrier".  Each of "count" threads
+// calls Wait(); none of them returns until all "count" have arrived.
+// The barrier then resets itself, so it can be used again.
+
+class Barrier {
+public:
+    Barrier(char *debugName, int count);   // "count" threads per round
+    ~Barrier();
+    char *getName() { return name; }
+
+    void Wait();        // wait for the rest of this round to arrive
+
+private:
+    char *name;
+    int parties;        // number of threads needed to open the barrier
+    int arrived;        // number of threads that have arrived this round
+    List *queue;        // threads waiting for the round to complete
+};
+
+// The following class defines a "countdown latch".  The latch starts
+// at "count"; CountDown() decrements it, and Wait() blocks until it
+// reaches zero.  Unlike a barrier, a latch opens only once.
+
+class Latch {
+public:
+    Latch(char *debugName, int count);
+    ~Latch();
+    char *getName() { return name; }
+
+    void CountDown();   // decrement the count, waking waiters at zero
+    void Wait();        // wait until the count reaches zero
+
+private:
+    char *name;
+    int value;          // remaining count, always >= 0
+    List *queue;        // threads waiting for the count to reach zero
 };
 
 #endif // SYNCH_H
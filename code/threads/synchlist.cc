@@ -20,12 +20,18 @@
 //	Allocate and initialize the data structures needed for a 
 //	synchronized list, empty to start with.
 //	Elements can now be added to the list.
+//
+//	"maxItems" -- if > 0, the most items the list holds before
+//		Append makes the caller wait
 //----------------------------------------------------------------------
 
-SynchList::SynchList() {
+SynchList::SynchList(int maxItems) {
     list = new List();
     lock = new Lock("list lock");
     listEmpty = new Condition("list empty cond");
+    listFull = new Condition("list full cond");
+    bound = maxItems;
+    numItems = 0;
 }
 
 //----------------------------------------------------------------------
@@ -37,6 +43,7 @@ SynchList::~SynchList() {
     delete list;
     delete lock;
     delete listEmpty;
+    delete listFull;
 }
 
 //----------------------------------------------------------------------
@@ -51,11 +58,36 @@ SynchList::~SynchList() {
 void
 SynchList::Append(void *item) {
     lock->Acquire();        // enforce mutual exclusive access to the list
+    while (bound > 0 && numItems == bound)
+        listFull->Wait(lock);        // wait until there is room
     list->Append(item);
+    numItems++;
     listEmpty->Signal(lock);    // wake up a waiter, if any
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchList::TryAppend
+//      Append an "item" to the end of the list, as Append does, unless
+//	the list is at its bound: then return FALSE at once, leaving the
+//	list as it was, rather than wait for room.
+//----------------------------------------------------------------------
+
+bool
+SynchList::TryAppend(void *item) {
+    bool room;
+
+    lock->Acquire();
+    room = (bound == 0 || numItems < bound);
+    if (room) {
+        list->Append(item);
+        numItems++;
+        listEmpty->Signal(lock);
+    }
+    lock->Release();
+    return room;
+}
+
 //----------------------------------------------------------------------
 // SynchList::Remove
 //      Remove an "item" from the beginning of the list.  Wait if
@@ -73,10 +105,80 @@ SynchList::Remove() {
         listEmpty->Wait(lock);        // wait until list isn't empty
     item = list->Remove();
     ASSERT(item != NULL);
+    numItems--;
+    if (bound > 0)
+        listFull->Signal(lock);    // make room for a waiting appender
     lock->Release();
     return item;
 }
 
+//----------------------------------------------------------------------
+// SynchList::AppendMany
+//      Append "n" items to the end of the list, in order, under one
+//	acquisition of the lock.  Waiters are woken once per batch
+//	rather than once per item.  On a bounded list, append what fits,
+//	wake the removers, and wait for room for the rest.
+//
+//	"items" -- the things to put on the list
+//	"n" -- how many there are
+//----------------------------------------------------------------------
+
+void
+SynchList::AppendMany(void **items, int n) {
+    int added;
+
+    lock->Acquire();
+    while (n > 0) {
+        while (bound > 0 && numItems == bound)
+            listFull->Wait(lock);
+        for (added = 0; added < n && (bound == 0 || numItems < bound);
+             added++, numItems++)
+            list->Append(items[added]);
+        items += added;
+        n -= added;
+        if (added == 1)
+            listEmpty->Signal(lock);
+        else
+            listEmpty->Broadcast(lock);    // Remove re-checks, so waking
+        // too many is harmless
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchList::RemoveUpTo
+//      Remove up to "n" items from the front of the list under one
+//	acquisition of the lock, waiting if the list is empty.
+// Returns:
+//	The number of items removed, at least 1.
+//
+//	"items" -- where to put the removed items
+//	"n" -- the most to remove
+//----------------------------------------------------------------------
+
+int
+SynchList::RemoveUpTo(void **items, int n) {
+    int removed;
+
+    ASSERT(n > 0);
+    lock->Acquire();
+    while (list->IsEmpty())
+        listEmpty->Wait(lock);
+    for (removed = 0; removed < n && !list->IsEmpty(); removed++) {
+        items[removed] = list->Remove();
+        ASSERT(items[removed] != NULL);
+    }
+    numItems -= removed;
+    if (bound > 0) {
+        if (removed == 1)
+            listFull->Signal(lock);
+        else
+            listFull->Broadcast(lock);
+    }
+    lock->Release();
+    return removed;
+}
+
 //----------------------------------------------------------------------
 // SynchList::Mapcar
 //      Apply function to every item on the list.  Obey mutual exclusion
@@ -20,16 +20,25 @@
 //	1. Threads trying to remove an item from a list will
 //	wait until the list has an element on it.
 //	2. One thread at a time can access list data structures
+//	3. If the list was given a bound, threads trying to append
+//	to a full list will wait until an element is removed.
 
 class SynchList {
 public:
-    SynchList();        // initialize a synchronized list
+    SynchList(int maxItems = 0);    // initialize a synchronized list;
+    // "maxItems" > 0 limits how many items it holds
     ~SynchList();        // de-allocate a synchronized list
 
     void Append(void *item);    // append item to the end of the list,
     // and wake up any thread waiting in remove
+    bool TryAppend(void *item);    // append item unless the list is
+    // at its bound; FALSE, not waiting, if it is
     void *Remove();        // remove the first item from the front of
     // the list, waiting if the list is empty
+    void AppendMany(void **items, int n);    // append n items, taking
+    // the lock once (per wait, if bounded)
+    int RemoveUpTo(void **items, int n);    // remove up to n items,
+    // waiting for at least one; returns how many
     // apply function to every item in the list
     void Mapcar(VoidFunctionPtr func);
 
@@ -37,6 +46,9 @@ private:
     List *list;            // the unsynchronized list
     Lock *lock;            // enforce mutual exclusive access to the list
     Condition *listEmpty;    // wait in Remove if the list is empty
+    Condition *listFull;    // wait in Append if the list is at its bound
+    int bound;            // most items allowed, 0 for no limit
+    int numItems;        // items on the list right now
 };
 
 #endif // SYNCHLIST_H
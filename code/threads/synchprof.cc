@@ -0,0 +1,123 @@
+// synchprof.cc 
+//	Routines to keep and print the synchronization contention
+//	profile.  See synchprof.h.
+//
+//	Records are created when a primitive is constructed, which may
+//	happen before Initialize (for global objects), so the record
+//	list is allocated on first use.  Records are never freed: a
+//	lock that has been deleted still shows up in the table.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprof.h"
+#include "list.h"
+#include "utility.h"
+
+static List *profiles = NULL;   // every SynchProfile, in creation order
+
+//----------------------------------------------------------------------
+// SynchProfile::SynchProfile
+// 	Initialize the counters for one named primitive to zero.
+//----------------------------------------------------------------------
+
+SynchProfile::SynchProfile(char *kindName, char *debugName) {
+    kind = kindName;
+    name = debugName;
+    acquires = contended = 0;
+    totalWait = maxWait = 0;
+    releases = totalHold = 0;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Acquired
+// 	Count an acquisition.  "waited" is the number of ticks between
+//	asking for the primitive and getting it.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Acquired(int waited) {
+    acquires++;
+    if (waited > 0) {
+        contended++;
+        totalWait += waited;
+        if (waited > maxWait)
+            maxWait = waited;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Released
+// 	Count a release, after the primitive was held for "held" ticks.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Released(int held) {
+    releases++;
+    totalHold += held;
+}
+
+//----------------------------------------------------------------------
+// SynchProfileFor
+// 	Return the record for "kind"/"name", creating it if needed.
+//	Called from the constructors of the synchronization primitives.
+//----------------------------------------------------------------------
+
+SynchProfile *
+SynchProfileFor(char *kind, char *name) {
+    SynchProfile *prof;
+    ListElement *ptr;
+
+    if (name == NULL)
+        name = "(unnamed)";
+    if (profiles == NULL)
+        profiles = new List;
+    for (ptr = profiles->getFirst(); ptr != NULL; ptr = ptr->next) {
+        prof = (SynchProfile *) ptr->item;
+        if (!strcmp(prof->kind, kind) && !strcmp(prof->name, name))
+            return prof;
+    }
+    prof = new SynchProfile(kind, name);
+    profiles->Append((void *) prof);
+    return prof;
+}
+
+//----------------------------------------------------------------------
+// SynchProfilePrint
+// 	Print the profile, worst total wait first.  Primitives that were
+//	never acquired are left out.  Called from Interrupt::Halt.
+//----------------------------------------------------------------------
+
+void
+SynchProfilePrint() {
+    List *sorted = new List;
+    SynchProfile *prof;
+    ListElement *ptr;
+    int key;
+
+    if (profiles == NULL)
+        return;
+    for (ptr = profiles->getFirst(); ptr != NULL; ptr = ptr->next) {
+        prof = (SynchProfile *) ptr->item;
+        if (prof->acquires > 0)
+            sorted->SortedInsert((void *) prof, -prof->totalWait);
+    }
+    if (!sorted->IsEmpty()) {
+        printf("Synchronization (ticks, worst total wait first):\n");
+        printf("%-10s %-20s %8s %9s %10s %8s %8s\n", "kind", "name",
+               "acquires", "contended", "total wait", "max wait",
+               "avg hold");
+    }
+    while ((prof = (SynchProfile *) sorted->SortedRemove(&key)) != NULL) {
+        printf("%-10s %-20s %8d %9d %10d %8d ", prof->kind, prof->name,
+               prof->acquires, prof->contended, prof->totalWait,
+               prof->maxWait);
+        if (prof->releases > 0)
+            printf("%8d\n", prof->totalHold / prof->releases);
+        else
+            printf("%8s\n", "-");
+    }
+    delete sorted;
+}
@@ -0,0 +1,50 @@
+// synchprof.h 
+//	Contention profiling for the kernel synchronization primitives.
+//
+//	Every Semaphore, Lock, Condition and RWLock is tied, by kind and
+//	debug name, to a SynchProfile record.  Primitives that share a
+//	name (say, one "fd table lock" per address space) share a record,
+//	so the table shows the cost of each *kind* of lock in the kernel.
+//
+//	For each record we count acquisitions, how many of them had to
+//	wait, the total and maximum wait, and (for locks) how long the
+//	lock was held.  Times are in simulated ticks.  The table, sorted
+//	by total wait, is printed when Nachos halts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROF_H
+#define SYNCHPROF_H
+
+#include "copyright.h"
+
+// The following class defines the counters kept for one named primitive.
+// The fields are public to make them easier to update.
+
+class SynchProfile {
+public:
+    SynchProfile(char *kindName, char *debugName);
+
+    void Acquired(int waited);  // an acquisition that waited "waited"
+    // ticks (0 if it did not block)
+    void Released(int held);    // a release after holding "held" ticks
+
+    char *kind;                 // "semaphore", "lock", ...
+    char *name;                 // debug name of the primitive(s)
+    int acquires;               // number of acquisitions
+    int contended;              // acquisitions that had to wait
+    int totalWait;              // ticks spent waiting, summed
+    int maxWait;                // longest single wait
+    int releases;               // releases that reported a hold time
+    int totalHold;              // ticks held, summed over releases
+};
+
+// Find (or create) the record for the primitive "kind"/"name".
+extern SynchProfile *SynchProfileFor(char *kind, char *name);
+
+// Print every record that was used, sorted by total wait.
+extern void SynchProfilePrint();
+
+#endif // SYNCHPROF_H
@@ -138,3 +138,50 @@ SynchTest() {
         ts[i]->Fork(SynchThread, i);
     }
 }
+
+//----------------------------------------------------------------------
+// BarrierTest
+// 	Exercise Barrier and Latch: BarrierTestThreads threads go through
+//	BarrierTestRounds rounds together, each arriving at the barrier
+//	after yielding a different number of times, and check on the way
+//	out that nobody has left the round early.  This thread waits on a
+//	latch until every one of them has finished.
+//----------------------------------------------------------------------
+
+#define BarrierTestThreads  4
+#define BarrierTestRounds   3
+
+static Barrier *roundBarrier;
+static Latch *doneLatch;
+static int roundOf[BarrierTestThreads];     // the round each thread is in
+
+static void
+BarrierThread(_int which) {
+    for (int round = 0; round < BarrierTestRounds; round++) {
+        roundOf[which] = round;
+        for (int i = 0; i < which; i++)     // arrive at different times
+            currentThread->Yield();
+        roundBarrier->Wait();
+        // everyone has reached this round, and nobody can be past the
+        // next barrier without us
+        for (int i = 0; i < BarrierTestThreads; i++)
+            ASSERT(roundOf[i] == round || roundOf[i] == round + 1);
+        printf("Barrier: thread %d through round %d\n", (int) which, round);
+    }
+    doneLatch->CountDown();
+}
+
+void
+BarrierTest() {
+    roundBarrier = new Barrier("round barrier", BarrierTestThreads);
+    doneLatch = new Latch("done latch", BarrierTestThreads);
+    for (int i = 0; i < BarrierTestThreads; i++) {
+        roundOf[i] = -1;
+        (new Thread("barrier thread"))->Fork(BarrierThread, i);
+    }
+    doneLatch->Wait();
+    printf("Barrier: %d threads through %d rounds\n", BarrierTestThreads,
+           BarrierTestRounds);
+    delete roundBarrier;
+    delete doneLatch;
+}
@@ -7,6 +7,10 @@
 
 #include "copyright.h"
 #include "system.h"
+#include "trace.h"
+#ifdef VM
+#include "synch.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -18,6 +22,7 @@ Interrupt *interrupt;            // interrupt status
 Statistics *stats;            // performance metrics
 Timer *timer;                // the hardware timer device,
 // for invoking context switches
+Alarm *alarmClock;            // kernel sleep service
 
 #ifdef FILESYS_NEEDED
 FileSystem *fileSystem;
@@ -30,6 +35,19 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM    // requires either FILESYS or FILESYS_STUB
 Machine *machine;    // user program memory and registers
+FileTable *fileTable;
+FutexTable *futexTable;
+#endif
+
+#ifdef VM
+FrameTable *frameTable;
+SwapSpace *swapSpace;
+TextCache *textCache;
+ShmTable *shmTable;
+Lock *pagingLock;
+#ifdef USE_TLB
+TLBManager *tlbManager;
+#endif
 #endif
 
 #ifdef NETWORK
@@ -78,6 +96,7 @@ void
 Initialize(int argc, char **argv) {
     int argCount;
     char *debugArgs = "";
+    char *traceFile = NULL;
     bool randomYield = FALSE;
 
 #ifdef USER_PROGRAM
@@ -87,6 +106,18 @@ Initialize(int argc, char **argv) {
 #ifdef FILESYS_NEEDED
     bool format = FALSE;    // format disk
 #endif
+#ifdef VM
+    ReplacePolicy replace = FIFOReplace;    // page replacement policy
+    int numFrames = 0;                      // frames user pages may use;
+                                            // 0 means all of them
+    int numZones = 1;                       // frame allocator zones
+#ifdef USE_TLB
+    int tlbEntries = TLBSize;               // TLB shape
+    int tlbWays = 0;                        // 0 means fully associative
+    TLBReplacePolicy tlbReplace = TLBRandomReplace;
+    bool superPages = FALSE;                // map superpages in the TLB
+#endif
+#endif
 #ifdef NETWORK
     double rely = 1;		// network reliability
     double order = 1;           // network orderability
@@ -102,6 +133,10 @@ Initialize(int argc, char **argv) {
                 debugArgs = *(argv + 1);
                 argCount = 2;
             }
+        } else if (!strcmp(*argv, "-trace")) {
+            ASSERT(argc > 1);
+            traceFile = *(argv + 1);
+            argCount = 2;
         } else if (!strcmp(*argv, "-rs")) {
             // LAB3: 在这里第一处理”rs"参数
             ASSERT(argc > 1);
@@ -113,11 +148,61 @@ Initialize(int argc, char **argv) {
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s"))
             debugUserProg = TRUE;
+        else if (!strcmp(*argv, "-ps")) {
+            ASSERT(argc > 1);
+            pageSize = atoi(*(argv + 1));   // checked by Machine::Machine
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f"))
             format = TRUE;
 #endif
+#ifdef VM
+        if (!strcmp(*argv, "-vr")) {
+            ASSERT(argc > 1);
+            if (!ReplacePolicyNamed(*(argv + 1), &replace)) {
+                printf("Unknown replacement policy %s\n", *(argv + 1));
+                ASSERT(FALSE);
+            }
+            argCount = 2;
+        } else if (!strcmp(*argv, "-vf")) {
+            ASSERT(argc > 1);
+            numFrames = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-vz")) {
+            ASSERT(argc > 1);
+            numZones = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-vp")) {
+            ASSERT(argc > 1);
+            maxPrefetch = atoi(*(argv + 1));
+            ASSERT(maxPrefetch >= 0 && maxPrefetch <= MaxPrefetch);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-vg")) {
+            pffControl = FALSE;
+        }
+#ifdef USE_TLB
+        if (!strcmp(*argv, "-tlb")) {
+            ASSERT(argc > 1);
+            tlbEntries = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlbw")) {
+            ASSERT(argc > 1);
+            tlbWays = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tlbr")) {
+            ASSERT(argc > 1);
+            if (!TLBReplacePolicyNamed(*(argv + 1), &tlbReplace)) {
+                printf("Unknown TLB replacement policy %s\n", *(argv + 1));
+                ASSERT(FALSE);
+            }
+            argCount = 2;
+        } else if (!strcmp(*argv, "-sp")) {
+            superPages = TRUE;
+        }
+#endif
+#endif
 #ifdef NETWORK
         if (!strcmp(*argv, "-n")) {
             ASSERT(argc > 1);
@@ -137,11 +222,14 @@ Initialize(int argc, char **argv) {
 
     DebugInit(debugArgs);            // initialize DEBUG messages
     stats = new Statistics();            // collect statistics
+    if (traceFile != NULL)              // needs stats for timestamps
+        TraceOpen(traceFile);
     interrupt = new Interrupt;            // 1. start up interrupt handling
     scheduler = new Scheduler();          // 2. initialize the ready queue
     // LAB3: 注册一个handler，一个随机域
     if (randomYield)                // start the timer (if needed)
         timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    alarmClock = new Alarm;
 
     threadToBeDestroyed = NULL;             // 3.
 
@@ -150,13 +238,22 @@ Initialize(int argc, char **argv) {
     // object to save its state. 
     currentThread = new Thread("main");     // 4.
     currentThread->setStatus(RUNNING);
+    TRACE('B', "sched", currentThread->getName(), TracePidThreads,
+          currentThread->getThreadId());
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);            // if user hits ctl-C
 
 #ifdef USER_PROGRAM
+#if defined(VM) && defined(USE_TLB)
+    machine = new Machine(debugUserProg, tlbEntries,
+                          (tlbWays == 0) ? tlbEntries : tlbWays);
+    machine->tlbSuperPages = superPages;
+    tlbManager = new TLBManager(tlbReplace);
+#else
     machine = new Machine(debugUserProg);    // this must come first
 #endif
+#endif
 
 // lab5: 在这里开始创建了 SynchDisk, FileSystem
 #ifdef FILESYS
@@ -167,6 +264,21 @@ Initialize(int argc, char **argv) {
     fileSystem = new FileSystem(format);
 #endif
 
+#ifdef USER_PROGRAM
+    fileTable = new FileTable;
+    futexTable = new FutexTable;
+#endif
+
+#ifdef VM
+    swapSpace = new SwapSpace("SWAP");
+    frameTable = new FrameTable((numFrames > 0) ? numFrames : NumPhysPages,
+                                replace, numZones);
+    textCache = new TextCache;
+    shmTable = new ShmTable;
+    pagingLock = new Lock("paging lock");
+    frameTable->StartPageDaemon();
+#endif
+
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, order, 10);
 #endif
@@ -183,7 +295,26 @@ Cleanup() {
     delete postOffice;
 #endif
 
+#ifdef VM
+    frameTable->Print();
+    textCache->Print();
+    shmTable->Print();
+#ifdef USE_TLB
+    tlbManager->Print();
+    delete tlbManager;
+#endif
+    delete frameTable;
+    delete textCache;
+    delete shmTable;
+    delete swapSpace;
+    delete pagingLock;
+#endif
+
 #ifdef USER_PROGRAM
+    fileTable->Print();
+    futexTable->Print();
+    delete fileTable;
+    delete futexTable;
     delete machine;
 #endif
 
@@ -196,9 +327,11 @@ Cleanup() {
 #endif
 
     delete timer;
+    delete alarmClock;
     delete scheduler;
     delete interrupt;
 
+    TraceClose();
     Exit(0);
 }
 
@@ -15,6 +15,7 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "alarm.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv);    // Initialization,
@@ -28,6 +29,7 @@ extern Scheduler *scheduler;            // the ready list
 extern Interrupt *interrupt;            // interrupt status
 extern Statistics *stats;            // performance metrics
 extern Timer *timer;                // the hardware alarm clock
+extern Alarm *alarmClock;            // wakes up sleeping threads
 
 #ifdef USER_PROGRAM
 
@@ -48,6 +50,30 @@ extern FileSystem *fileSystem;
 extern SynchDisk   *synchDisk;
 #endif
 
+#ifdef USER_PROGRAM
+#include "filetable.h"
+#include "futex.h"
+extern FileTable *fileTable;    // the files user programs have open
+extern FutexTable *futexTable;  // user processes waiting on user locks
+#endif
+
+#ifdef VM
+#include "frametable.h"
+#include "swap.h"
+#include "textcache.h"
+#include "shm.h"
+class Lock;
+extern FrameTable *frameTable;  // who holds each physical page
+extern SwapSpace *swapSpace;    // where evicted pages go
+extern TextCache *textCache;    // code pages shared between processes
+extern ShmTable *shmTable;      // shared memory segments
+extern Lock *pagingLock;        // one page fault or eviction at a time
+#ifdef USE_TLB
+#include "tlbmanager.h"
+extern TLBManager *tlbManager;  // refills the TLB on a miss
+#endif
+#endif
+
 #ifdef NETWORK
 #include "post.h"
 extern PostOffice* postOffice;
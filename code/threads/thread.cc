@@ -19,6 +19,7 @@
 #include "switch.h"
 #include "synch.h"
 #include "system.h"
+#include "trace.h"
 
 #define STACK_FENCEPOST 0xdeadbeef    // this is put at the top of the
 // execution stack, for detecting
@@ -26,6 +27,8 @@
 
 int waitingThreadExitCode;
 
+static int nextThreadId = 1;    // 0 is reserved in event traces
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -41,9 +44,21 @@ Thread::Thread(char *threadName) {
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    threadId = nextThreadId++;
+    if (traceEnabled) {
+        TraceName(TracePidThreads, threadId, name);
+        TraceName(TracePidSyscalls, threadId, name);
+    }
+    stateSince = dispatchUserTicks = dispatchSystemTicks = 0;
+    if (stats != NULL) {
+        stateSince = stats->totalTicks;
+        dispatchUserTicks = stats->userTicks;
+        dispatchSystemTicks = stats->systemTicks;
+    }
 #ifdef USER_PROGRAM
     space = NULL;
 #endif
+    scheduler->AddThread(this);
 }
 
 //----------------------------------------------------------------------
@@ -62,6 +77,7 @@ Thread::~Thread() {
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
+    scheduler->RemoveThread(this);
     if (stack != NULL)
         DeallocBoundedArray((char *) stack, StackSize * sizeof(_int));
 }
@@ -261,6 +277,107 @@ Thread::Sleep() {
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// ThreadStats::ThreadStats
+// 	Start all the per-thread counters at zero.
+//----------------------------------------------------------------------
+
+ThreadStats::ThreadStats() {
+    userTicks = systemTicks = 0;
+    readyTicks = blockedTicks = 0;
+    voluntarySwitches = involuntarySwitches = 0;
+    numPageFaults = 0;
+}
+
+//----------------------------------------------------------------------
+// Thread::AccountReady
+// 	The thread is being put on the ready list.  If it was blocked,
+//	charge the time since it went to sleep as blocked time.
+//
+//	Called by Scheduler::ReadyToRun, before the status changes.
+//----------------------------------------------------------------------
+
+void
+Thread::AccountReady() {
+    if (status == BLOCKED)
+        accounting.blockedTicks += stats->totalTicks - stateSince;
+    stateSince = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Thread::AccountDispatch
+// 	The thread is about to be given the CPU.  Charge the time it
+//	spent on the ready list, and remember the global tick counters
+//	so its CPU time can be worked out when it is switched out.
+//----------------------------------------------------------------------
+
+void
+Thread::AccountDispatch() {
+    accounting.readyTicks += stats->totalTicks - stateSince;
+    stateSince = stats->totalTicks;
+    dispatchUserTicks = stats->userTicks;
+    dispatchSystemTicks = stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Thread::AccountSwitchOut
+// 	The thread is losing the CPU.  Charge the user and system ticks
+//	since it was dispatched, and count the context switch:
+//	blocking is always voluntary, going back on the ready list is
+//	involuntary only if the timer forced it.
+//
+//	"preempted" -- TRUE if this switch is a time-slice preemption
+//----------------------------------------------------------------------
+
+void
+Thread::AccountSwitchOut(bool preempted) {
+    accounting.userTicks += stats->userTicks - dispatchUserTicks;
+    accounting.systemTicks += stats->systemTicks - dispatchSystemTicks;
+    stateSince = stats->totalTicks;
+    if (status == READY && preempted)
+        accounting.involuntarySwitches++;
+    else if (status == READY || status == BLOCKED)
+        accounting.voluntarySwitches++;
+}
+
+//----------------------------------------------------------------------
+// Thread::GetStats
+// 	Copy this thread's counters into "st".  If the thread is running
+//	right now, its CPU time includes the ticks since it was dispatched.
+//----------------------------------------------------------------------
+
+void
+Thread::GetStats(ThreadStats *st) {
+    *st = accounting;
+    if (this == currentThread) {
+        st->userTicks += stats->userTicks - dispatchUserTicks;
+        st->systemTicks += stats->systemTicks - dispatchSystemTicks;
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::PrintStats
+// 	Print one line of the "ps" listing for this thread.
+//----------------------------------------------------------------------
+
+void
+Thread::PrintStats() {
+    static char *statusNames[] = {"NEW", "RUN", "READY", "BLOCK", "TERM"};
+    ThreadStats st;
+
+    GetStats(&st);
+#ifdef USER_PROGRAM
+    if (space != NULL)
+        printf("%4d ", space->getSpaceID());
+    else
+#endif
+        printf("   - ");
+    printf("%-16s %-5s %7d %7d %7d %7d %5d %5d %5d\n", name,
+           statusNames[status], st.userTicks, st.systemTicks,
+           st.readyTicks, st.blockedTicks, st.voluntarySwitches,
+           st.involuntarySwitches, st.numPageFaults);
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -421,12 +538,16 @@ Thread::SaveUserState() {
 //	Note that a user program thread has *two* sets of CPU registers --
 //	one for its state while executing user code, one for its state
 //	while executing kernel code.  This routine restores the former.
+//
+//	Any LL reservation belonged to whoever ran last, and another
+//	thread may have stored to the word since: a pending SC fails.
 //----------------------------------------------------------------------
 
 void
 Thread::RestoreUserState() {
     for (int i = 0; i < NumTotalRegs; i++)
         machine->WriteRegister(i, userRegisters[i]);
+    machine->llAddr = -1;
 }
 
 // Join 将当前线程睡眠
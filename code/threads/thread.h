@@ -67,6 +67,24 @@ enum ThreadStatus {
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(_int arg);
 
+// Per-thread CPU and scheduling accounting.  The counters are kept
+// up to date by the scheduler on every state change (see
+// Scheduler::ReadyToRun and Scheduler::Run); CPU time is charged by
+// sampling the global Statistics when the thread is switched out.
+
+class ThreadStats {
+public:
+    ThreadStats();              // all counters start at zero
+
+    int userTicks;              // user-mode ticks while running
+    int systemTicks;            // kernel-mode ticks while running
+    int readyTicks;             // ticks spent waiting on the ready list
+    int blockedTicks;           // ticks spent blocked in Sleep()
+    int voluntarySwitches;      // gave up the CPU by blocking or Yield()
+    int involuntarySwitches;    // had the CPU taken away by the timer
+    int numPageFaults;          // page faults taken by this thread
+};
+
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
 //
@@ -107,12 +125,24 @@ public:
 
     char *getName() { return (name); }
 
+    int getThreadId() { return threadId; }
+
     void Print() { printf("%s, ", name); }
 
     void Join(int SpaceId);
 
     void Terminated();
 
+    ThreadStats accounting;         // CPU and scheduling counters
+
+    void AccountReady();            // called by the scheduler when this
+    void AccountDispatch();         // thread becomes ready, is given the
+    void AccountSwitchOut(bool preempted);  // CPU, or loses the CPU
+
+    void GetStats(ThreadStats *st); // copy of "accounting", including
+    // the time since the last dispatch
+    void PrintStats();              // one line of the "ps" listing
+
 private:
     // some of the private data for this class is listed above
 
@@ -121,6 +151,12 @@ private:
     // (If NULL, don't deallocate stack)
     ThreadStatus status;        // ready, running or blocked
     char *name;
+    int threadId;               // unique, never reused; names the
+    // thread's tracks in an event trace
+
+    int stateSince;             // tick of the last accounted status change
+    int dispatchUserTicks;      // global user/system ticks when this
+    int dispatchSystemTicks;    // thread was last given the CPU
 
     void StackAllocate(VoidFunctionPtr func, _int arg);
     // Allocate a stack for thread.
@@ -12,6 +12,8 @@
 #include "copyright.h"
 #include "system.h"
 
+#include <sys/time.h>
+
 //----------------------------------------------------------------------
 // SimpleThread
 // 	Loop 5 times, yielding the CPU to another ready thread 
@@ -59,3 +61,41 @@ ThreadTest() {
     SimpleThread(0);
 }
 
+
+//----------------------------------------------------------------------
+// SwitchBench
+// 	Measure the cost of a context switch: ping-pong between two
+//	threads by calling Thread::Yield, and report host nanoseconds and
+//	simulated ticks per switch.  Each round is two switches, one to
+//	the partner and one back.
+//----------------------------------------------------------------------
+
+#define SwitchBenchRounds 100000
+
+static void
+SwitchPartner(_int rounds) {
+    for (int i = 0; i < rounds; i++)
+        currentThread->Yield();
+}
+
+void
+SwitchBench() {
+    struct timeval start, end;
+    int startTicks, switches = 2 * SwitchBenchRounds;
+    double nsecs;
+
+    (new Thread("switch partner"))->Fork(SwitchPartner, SwitchBenchRounds);
+    currentThread->Yield();             // let the partner get going
+
+    startTicks = stats->totalTicks;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < SwitchBenchRounds; i++)
+        currentThread->Yield();
+    gettimeofday(&end, NULL);
+
+    nsecs = (end.tv_sec - start.tv_sec) * 1e9 +
+            (end.tv_usec - start.tv_usec) * 1e3;
+    printf("Context switch: %d switches, %.1f ns/switch (host), "
+           "%.2f ticks/switch\n", switches, nsecs / switches,
+           (double) (stats->totalTicks - startTicks) / switches);
+}
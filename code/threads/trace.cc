@@ -0,0 +1,125 @@
+// trace.cc 
+//	Routines to write kernel events as a Chrome trace-event file
+//	(the "JSON Array Format": one object per event, in one array).
+//
+//	Events go straight to a stdio stream, so the cost of an event
+//	is one buffered fprintf; nothing is kept in memory.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+bool traceEnabled = FALSE;
+
+static FILE *traceFile = NULL;
+static int traceEvents = 0;     // number of events written so far
+
+//----------------------------------------------------------------------
+// TraceSeparator
+// 	Events in the array are separated by commas.
+//----------------------------------------------------------------------
+
+static void
+TraceSeparator() {
+    fprintf(traceFile, traceEvents++ == 0 ? "\n" : ",\n");
+}
+
+//----------------------------------------------------------------------
+// TraceOpen
+// 	Create "fileName" and start recording events into it.  Must be
+//	called after "stats" exists, since events are stamped with
+//	stats->totalTicks.
+//----------------------------------------------------------------------
+
+void
+TraceOpen(char *fileName) {
+    traceFile = fopen(fileName, "w");
+    if (traceFile == NULL) {
+        fprintf(stderr, "Trace: unable to open %s\n", fileName);
+        return;
+    }
+    fprintf(traceFile, "[");
+    traceEnabled = TRUE;
+
+    TraceName(TracePidThreads, 0, "threads");
+    TraceName(TracePidDevices, 0, "devices");
+    TraceName(TracePidSyscalls, 0, "syscalls");
+    TraceName(TracePidDevices, TraceTidDisk, "disk requests");
+    TraceName(TracePidDevices, TraceTidIdle, "idle");
+}
+
+//----------------------------------------------------------------------
+// TraceClose
+// 	Close the event array and the file.  Called from Cleanup.
+//----------------------------------------------------------------------
+
+void
+TraceClose() {
+    if (traceFile == NULL)
+        return;
+    traceEnabled = FALSE;
+    fprintf(traceFile, "\n]\n");
+    fclose(traceFile);
+    traceFile = NULL;
+}
+
+//----------------------------------------------------------------------
+// TraceRecord
+// 	Write one event, stamped with the current simulated time.
+//----------------------------------------------------------------------
+
+void
+TraceRecord(char phase, const char *category, const char *name,
+            int pid, int tid, const char *argName, int argValue) {
+    if (traceFile == NULL)
+        return;
+    TraceSeparator();
+    fprintf(traceFile, "{\"ph\":\"%c\",\"cat\":\"%s\",\"name\":\"%s\","
+                       "\"pid\":%d,\"tid\":%d,\"ts\":%d",
+            phase, category, name, pid, tid, stats->totalTicks);
+    if (phase == 'i')
+        fprintf(traceFile, ",\"s\":\"t\"");
+    if (argName != NULL)
+        fprintf(traceFile, ",\"args\":{\"%s\":%d}", argName, argValue);
+    fprintf(traceFile, "}");
+}
+
+//----------------------------------------------------------------------
+// TraceSpan
+// 	Write a complete ('X') event running from "start" to now.
+//----------------------------------------------------------------------
+
+void
+TraceSpan(const char *category, const char *name, int pid, int tid,
+          int start) {
+    if (traceFile == NULL)
+        return;
+    TraceSeparator();
+    fprintf(traceFile, "{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\","
+                       "\"pid\":%d,\"tid\":%d,\"ts\":%d,\"dur\":%d}",
+            category, name, pid, tid, start, stats->totalTicks - start);
+}
+
+//----------------------------------------------------------------------
+// TraceName
+// 	Give a track (or, with tid 0, a whole group) a name in the viewer.
+//----------------------------------------------------------------------
+
+void
+TraceName(int pid, int tid, const char *name) {
+    if (traceFile == NULL)
+        return;
+    TraceSeparator();
+    if (tid == 0)
+        fprintf(traceFile, "{\"ph\":\"M\",\"name\":\"process_name\","
+                           "\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+                pid, name);
+    else
+        fprintf(traceFile, "{\"ph\":\"M\",\"name\":\"thread_name\","
+                           "\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                pid, tid, name);
+}
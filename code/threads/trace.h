@@ -0,0 +1,74 @@
+// trace.h 
+//	Event tracing for the Nachos kernel, in the Chrome trace-event
+//	format, so that a run can be loaded into chrome://tracing or
+//	Perfetto and viewed as a timeline.
+//
+//	Timestamps are simulated ticks (stats->totalTicks); the viewer
+//	will label them microseconds.  Events are grouped into "processes"
+//	in the viewer:
+//
+//	    TracePidThreads  -- one track per thread, a span while it
+//				holds the CPU
+//	    TracePidDevices  -- interrupt handlers (one track per IntType),
+//				disk requests and idle time
+//	    TracePidSyscalls -- one track per thread, a span per syscall
+//
+//	Tracing is turned on with "-trace <file>".  When it is off, each
+//	instrumentation point costs a single test of "traceEnabled".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+
+// Viewer "process" ids
+#define TracePidThreads     1
+#define TracePidDevices     2
+#define TracePidSyscalls    3
+
+// Tracks under TracePidDevices, besides one per IntType
+#define TraceTidDisk        100
+#define TraceTidIdle        101
+
+extern bool traceEnabled;               // is anyone listening?
+
+extern void TraceOpen(char *fileName);  // start writing events
+extern void TraceClose();               // finish the file
+
+// Record one event at the current time.  "phase" is the trace-event
+// phase: 'B' begin span, 'E' end span, 'i' instant.  If "argName" is
+// non-NULL, "argValue" is attached to the event.
+extern void TraceRecord(char phase, const char *category, const char *name,
+                        int pid, int tid, const char *argName, int argValue);
+
+// Record a span that started at "start" and ends now.
+extern void TraceSpan(const char *category, const char *name,
+                      int pid, int tid, int start);
+
+// Label a track in the viewer.
+extern void TraceName(int pid, int tid, const char *name);
+
+//----------------------------------------------------------------------
+// TRACE, TRACE_ARG
+//      Record an event, if tracing is enabled.  These are macros so
+//	that the disabled case is just the test of "traceEnabled".
+//----------------------------------------------------------------------
+
+#define TRACE(phase, category, name, pid, tid)                          \
+    do {                                                                \
+        if (traceEnabled)                                               \
+            TraceRecord(phase, category, name, pid, tid, NULL, 0);      \
+    } while (0)
+
+#define TRACE_ARG(phase, category, name, pid, tid, argName, argValue)   \
+    do {                                                                \
+        if (traceEnabled)                                               \
+            TraceRecord(phase, category, name, pid, tid,                \
+                        argName, argValue);                             \
+    } while (0)
+
+#endif // TRACE_H
@@ -18,9 +18,13 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
-#include "bitmap.h"
+#include "framealloc.h"
+#include "idalloc.h"
 #include "openfile.h"
+#include "synch.h"
+#ifdef VM
+#include "filehdr.h"
+#endif
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -55,51 +59,105 @@ SwapHeader(NoffHeader *noffH) {
 //	memory.  For now, this is really simple (1:1), since we are
 //	only uniprogramming, and we have a single unsegmented page table
 //
-//	"executable" is the file containing the object code to load into memory
+//	"executable" is the file containing the object code to load into memory.
+//	The address space takes it over: with VM, pages are loaded from it
+//	on demand, so it stays open until the address space is deleted.
 //----------------------------------------------------------------------
 
-BitMap *bitmap;
+#ifndef VM
+FrameAllocator *frameAllocator;     // physical frames (the frame table's,
+                                    // with VM)
+#else
+int maxPrefetch = DefaultPrefetch;  // -vp may change it
+bool pffControl = TRUE;             // -vg turns it off
+
+PagingStats::PagingStats() {
+    residentPages = majorFaults = minorFaults = 0;
+    swapIns = swapOuts = workingSet = 0;
+    frameLimit = InitialFrameLimit;
+}
+#endif
+
+//----------------------------------------------------------------------
+// SegmentsEnd
+// 	Return the virtual address just past the last of the program's
+//	segments.  They needn't be packed together: test/script starts the
+//	data on a page of its own, after a gap.
+//----------------------------------------------------------------------
+
+static int
+SegmentsEnd(NoffHeader *noffH) {
+    int end = 0;
+
+    if (noffH->code.size > 0)
+        end = max(end, noffH->code.virtualAddr + noffH->code.size);
+    if (noffH->initData.size > 0)
+        end = max(end, noffH->initData.virtualAddr + noffH->initData.size);
+    if (noffH->uninitData.size > 0)
+        end = max(end, noffH->uninitData.virtualAddr + noffH->uninitData.size);
+    return end;
+}
+
+#ifndef VM
+//----------------------------------------------------------------------
+// CopySegment
+// 	Read segment "seg" of "executable" into the frames "pageTable"
+//	maps it to, a page at a time: consecutive pages needn't be in
+//	consecutive frames (FrameAllocator hands them out in any order).
+//----------------------------------------------------------------------
+
+static void
+CopySegment(OpenFile *executable, PageTable *pageTable, Segment *seg) {
+    int addr = seg->virtualAddr;
+    int segEnd = seg->virtualAddr + seg->size;
+
+    while (addr < segEnd) {
+        int vpn = addr / PageSize;
+        int end = min(segEnd, (vpn + 1) * PageSize);
+        int physAddr = pageTable->Lookup(vpn)->physicalPage * PageSize
+                       + addr % PageSize;
+
+        executable->ReadAt(&(machine->mainMemory[physAddr]), end - addr,
+                           seg->inFileAddr + (addr - seg->virtualAddr));
+        addr = end;
+    }
+}
+#endif
+
 bool ThreadMap[MAX_USERPOCESSES]; // lab78: 这个初始化其实默认了还没有分配
+static IdAllocator *spaceIDs;       // the free entries of ThreadMap
 
-AddrSpace::AddrSpace(OpenFile *executable) {
-    NoffHeader noffH;
+AddrSpace::AddrSpace(OpenFile *file) {
+    NoffHeader header;
     unsigned int i, size;
 
     // --------------- !! added by yourself ???? ----------------------
     // 一次最多允许 MAX_USERPROCESSES user processes execcutables concurrently.
     // spaceID, i.e. pid
     // lab78: 也就是说，这里我们首先尝试去分配一个 spaceID
-    bool hasAvailablePid = false;
-    for (int i = 100; i < MAX_USERPOCESSES; i++) { // 0~99 是内核
-        // lab78: 这里的 threadMap 是什么东西？
-        if (!ThreadMap[i]) {
-            ThreadMap[i] = true;
-            spaceID = i;  // lab78: 这个到底是从哪来的？？？
-            hasAvailablePid = true;
-            break;
-        }
-    }
-    if (!hasAvailablePid) {
+    if (!AllocateSpaceID()) {
         printf("Too many process in Nachos. \n");
         return;
     }
 
+#ifndef VM                      // with VM, the frame table does this
     // lab78: 也就是说第一次到此时才会创建全局的物理页的映射
-    if (bitmap == NULL)
-        bitmap = new BitMap(NumPhysPages);
+    if (frameAllocator == NULL)
+        frameAllocator = new FrameAllocator(NumPhysPages, 1);
+#endif
 
-    // lab6: 首先把 noffH 给读出来
-    executable->ReadAt((char *) &noffH, sizeof(noffH), 0);
+    // lab6: 首先把 header 给读出来
+    file->ReadAt((char *) &header, sizeof(header), 0);
     // lab6: 为什么要做 SwapHeader?
-    if ((noffH.noffMagic != NOFFMAGIC) &&
-        (WordToHost(noffH.noffMagic) == NOFFMAGIC))
-        SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    if ((header.noffMagic != NOFFMAGIC) &&
+        (WordToHost(header.noffMagic) == NOFFMAGIC))
+        SwapHeader(&header);
+    ASSERT(header.noffMagic == NOFFMAGIC);
 
 // how big is address space?
     // lab6: 计算整个地址空间的大小 ?
     //  并且额外计算一部分栈的空间
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size
+    size = SegmentsEnd(&header)
            + UserStackSize;    // we need to increase the size
     // to leave room for the stack
 
@@ -107,14 +165,38 @@ AddrSpace::AddrSpace(OpenFile *executable) {
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);        // check we're not trying
+#ifndef VM
+    ASSERT(numPages <= (unsigned) NumPhysPages);    // check we're not trying
     // to run anything too big --
     // at least until we have
     // virtual memory
+#endif
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n",
           numPages, size);
 
+#ifdef VM
+    // Demand paging: nothing is read in yet.  Every page starts out
+    // invalid, and is filled from the executable (code, initData) or
+    // with zeros (uninitData, heap, stack) the first time it is touched
+    // -- see AddrSpace::PageFault.
+    //
+    // Above the segments is room for the heap to grow into (see Sbrk),
+    // then the stack, then the region where files are mapped.
+    executable = new SharedExecutable(file);
+    noffH = header;
+    heapBase = divRoundUp(SegmentsEnd(&header), PageSize);
+    brk = heapBase * PageSize;  // the heap starts out empty
+    stackBase = heapBase + divRoundUp(HeapRegionSize, PageSize);
+    mmapBase = stackBase + divRoundUp(UserStackSize, PageSize);
+    numPages = mmapBase + divRoundUp(MmapRegionSize, PageSize);
+    mapOf = new Mapping *[numPages - mmapBase];
+    for (i = 0; i < numPages - mmapBase; i++)
+        mapOf[i] = NULL;
+    pageTable = new PageTable(numPages);    // entries start out invalid
+    InitPaging();
+#else
+
 //// first, set up the translation
 //    // lab6: 创建页表, 并做初始化
 //    //  其实我们发现，载入程序的时候，该文件的 code 和 data 都放入了物理内存
@@ -130,67 +212,148 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 //        // a separate page, we could set its
 //        // pages to be read-only
 //    }
-    pageTable = new TranslationEntry[numPages];
+    pageTable = new PageTable(numPages);
     for (i = 0; i < numPages; i++) {
-        pageTable[i].virtualPage = i;    // for now, virtual page # = phys page #
-        pageTable[i].physicalPage = bitmap->Find();
-        ASSERT(pageTable[i].physicalPage != -1);
-        pageTable[i].valid = TRUE;
-        pageTable[i].use = FALSE;
-        pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;  // if the code segment was entirely on
+        TranslationEntry *entry = pageTable->Entry(i);
+        entry->physicalPage = frameAllocator->Allocate(0);
+        ASSERT(entry->physicalPage != -1);
+        entry->valid = TRUE;    // use, dirty and readOnly start FALSE;
+        // if the code segment was entirely on
         // a separate page, we could set its
         // pages to be read-only
+        // zero the frame, for the uninitialized data and the stack
+        bzero(&(machine->mainMemory[entry->physicalPage * PageSize]), PageSize);
     }
 
-
-// zero out the entire address space, to zero the unitialized data segment
-// and the stack segment
-    // lab78: 我们在思考一个问题，下面这句应当注释掉，因为我们使用了位视图
-    //  用来分配物理内存的空间，所以没必要先清零内存。
-//    bzero(machine->mainMemory, size);
-
 // then, copy in the code and data segments into memory
-    if (noffH.code.size > 0) {
+    if (header.code.size > 0) {
         DEBUG('a', "Initializing code segment, at 0x%x, size %d\n",
-              noffH.code.virtualAddr, noffH.code.size);
-        // lab6: 如果代码区不为空，那么就读到主存的某个位置去？
-        // lab78：如果这样读进来岂不是有问题？
-        //  我们似乎需要将几个段的开头都读进来
-//        executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
-//                           noffH.code.size, noffH.code.inFileAddr);
-        // lab78: 我们首先按照一个不太对的方法来实现吧：因为可能潜在的内存不连续
-        int code_page = noffH.code.virtualAddr / PageSize;
-        int code_offset = noffH.code.virtualAddr % PageSize;
-        int code_phy_addr = pageTable[code_page].physicalPage * PageSize + code_offset;
-        executable->ReadAt(&(machine->mainMemory[code_phy_addr]),
-                           noffH.code.size, noffH.code.inFileAddr);
-    }
-    if (noffH.initData.size > 0) {
+              header.code.virtualAddr, header.code.size);
+        CopySegment(file, pageTable, &header.code);
+    }
+    if (header.initData.size > 0) {
         DEBUG('a', "Initializing data segment, at 0x%x, size %d\n",
-              noffH.initData.virtualAddr, noffH.initData.size);
-        // lab6: 如果代码的数据区不为空，那么就读到主存的某个位置上去
-        //  这里有一个和上面同样的问题 —— 为什么是虚地址, 但是使用的是物理内存?
-//        executable->ReadAt(&(machine->mainMemory[noffH.initData.virtualAddr]),
-//                           noffH.initData.size, noffH.initData.inFileAddr);
-        // lab78: 我们首先按照一个不太对的方法来实现吧：因为可能潜在的内存不连续
-        int data_page = noffH.initData.virtualAddr / PageSize;
-        int data_offset = noffH.initData.virtualAddr % PageSize;
-        int data_phy_addr = pageTable[data_page].physicalPage * PageSize + data_offset;
-        executable->ReadAt(&(machine->mainMemory[data_phy_addr]),
-                           noffH.initData.size, noffH.initData.inFileAddr);
+              header.initData.virtualAddr, header.initData.size);
+        CopySegment(file, pageTable, &header.initData);
+    }
+    delete file;                // everything we need is in memory
+#endif // VM
+
+
+    fds = new FdTable;
+}
+
+#ifdef VM
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Create the address space of a process Forked from "parent": the
+//	same pages, without copying any of them.  Resident pages end up
+//	mapped read-only in both page tables, sharing the parent's frame,
+//	and whichever process writes one first gets its own copy (see
+//	CopyOnWrite).  Pages the parent hasn't touched are loaded on
+//	demand from the same executable, so only swapped-out pages need
+//	copying now -- each process needs its own swap slot.  A resident
+//	page whose only other copy is in the parent's slot is marked dirty
+//	in the child, which then saves it to a slot of its own if it
+//	evicts it.
+//
+//	The child inherits the parent's file descriptors, sharing their
+//	offsets, and its shared memory segments, at the same addresses,
+//	but no files mapped.
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(AddrSpace *parent) {
+    if (!AllocateSpaceID()) {
+        printf("Too many process in Nachos. \n");
+        ASSERT(FALSE);
     }
 
+    numPages = parent->numPages;
+    heapBase = parent->heapBase;
+    brk = parent->brk;
+    stackBase = parent->stackBase;
+    mmapBase = parent->mmapBase;
+    mapOf = new Mapping *[numPages - mmapBase];
+    for (unsigned int i = 0; i < numPages - mmapBase; i++)
+        mapOf[i] = NULL;
+    noffH = parent->noffH;
+    executable = parent->executable;
+    executable->refCount++;
+    pageTable = new PageTable(numPages);
+    InitPaging();
+    paging.frameLimit = parent->paging.frameLimit;
 
+    pagingLock->Acquire();
+    for (TranslationEntry *theirs = parent->pageTable->Next(NULL);
+         theirs != NULL; theirs = parent->pageTable->Next(theirs)) {
+        unsigned int i = theirs->virtualPage;
+        PageInfo *parentInfo = parent->pageTable->Info(theirs);
 
-    for (int i=3;i<10;i++)    //up to open 10 file for each process
-        fileDescriptor[i] = NULL;
+        if (i >= mmapBase)      // in a mapped file
+            continue;
+        if (theirs->valid) {
+#ifdef USE_TLB
+            tlbManager->Invalidate(parent, i);  // it may be writable there
+#endif
+            if (!theirs->readOnly) {
+                theirs->readOnly = TRUE;
+                parentInfo->copyOnWrite = TRUE;
+            }
+            frameTable->Share(theirs->physicalPage, this, i);
+            paging.residentPages++;
+        }
+        TranslationEntry *mine = pageTable->Entry(i);
+        PageInfo *info = pageTable->Info(mine);
+
+        *mine = *theirs;
+        mine->use = FALSE;
+        info->copyOnWrite = parentInfo->copyOnWrite;    // as just marked
+        if (theirs->valid && parentInfo->swapSlot != -1)
+            mine->dirty = TRUE;         // only the parent's slot has it:
+                                        // save it before evicting it
+        if (!theirs->valid && parentInfo->swapSlot != -1) {
+            char *buffer = new char[PageSize];
+
+            info->swapSlot = swapSpace->Allocate();
+            if (info->swapSlot == -1) {
+                printf("Out of swap space, forking process %d\n",
+                       parent->spaceID);
+                ASSERT(FALSE);
+            }
+            swapSpace->ReadPage(parentInfo->swapSlot, buffer);
+            swapSpace->WritePage(info->swapSlot, buffer);
+            delete[] buffer;
+        }
+    }
+    for (unsigned int i = mmapBase; i < numPages; i++) {
+        Mapping *m = parent->MappingOf(i);
+
+        if (m != NULL && m->shm != NULL && m->first == i)
+            MapSegment(m->shm, i);
+    }
+    pagingLock->Release();
+
+    fds = new FdTable(parent->fds);
+}
+#endif
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocateSpaceID
+// 	Claim an unused spaceID (process id), in constant time.  Returns
+//	FALSE, leaving spaceID -1, if MAX_USERPOCESSES processes already
+//	exist.
+//----------------------------------------------------------------------
 
-    OpenFile *StdinFile = new OpenFile("stdin");
-    OpenFile *StdoutFile = new OpenFile("stdout");
-    fileDescriptor[0] =  StdinFile;
-    fileDescriptor[1] =  StdoutFile;
-    fileDescriptor[2] =  StdoutFile;
+bool
+AddrSpace::AllocateSpaceID() {
+    if (spaceIDs == NULL)
+        spaceIDs = new IdAllocator(100, MAX_USERPOCESSES - 1);   // 0~99 是内核
+    spaceID = spaceIDs->Allocate();
+    if (spaceID == -1)
+        return FALSE;
+    ASSERT(!ThreadMap[spaceID]);
+    ThreadMap[spaceID] = true;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -199,11 +362,22 @@ AddrSpace::AddrSpace(OpenFile *executable) {
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace() {
-    ThreadMap[spaceID] = 0;
-    for (int i = 0; i < numPages; i++) {
-        bitmap->Clear(pageTable[i].physicalPage);
+    if (spaceID != -1) {
+        ThreadMap[spaceID] = 0;
+        spaceIDs->Free(spaceID);
     }
-    delete[] pageTable;
+#ifdef VM
+    ReleasePages();
+    delete[] mapOf;
+    if (--executable->refCount == 0)
+        delete executable;
+#else
+    for (unsigned int i = 0; i < numPages; i++) {
+        frameAllocator->Free(pageTable->Lookup(i)->physicalPage);
+    }
+#endif
+    delete pageTable;
+    delete fds;
 }
 
 //----------------------------------------------------------------------
@@ -232,9 +406,15 @@ AddrSpace::InitRegisters() {
 
     // Set the stack register to the end of the address space, where we
     // allocated the stack; but subtract off a bit, to make sure we don't
-    // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG('a', "Initializing stack register to %d\n", numPages * PageSize - 16);
+    // accidentally reference off the end!  (With VM, the region for
+    // mapped files comes after the stack.)
+#ifdef VM
+    int stackTop = mmapBase * PageSize;
+#else
+    int stackTop = numPages * PageSize;
+#endif
+    machine->WriteRegister(StackReg, stackTop - 16);
+    DEBUG('a', "Initializing stack register to %d\n", stackTop - 16);
 }
 
 //----------------------------------------------------------------------
@@ -252,35 +432,1262 @@ void AddrSpace::SaveState() {}
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      Without a TLB, tell the machine where to find the page table.
+//	With one, just switch the machine to our ASID: TLB entries are
+//	tagged, so other address spaces' can stay where they are.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() {
-    machine->pageTable = pageTable;
-    machine->pageTableSize = numPages;
+#ifdef USE_TLB
+    machine->tlbASID = spaceID;
+#else
+    machine->pageTableRoot = pageTable;
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsLoaded
+// 	Return TRUE if the machine is already set up to run in this
+//	address space, so that RestoreState would change nothing.
+//----------------------------------------------------------------------
+
+bool AddrSpace::IsLoaded() {
+#ifdef USE_TLB
+    return machine->tlbASID == spaceID;
+#else
+    return machine->pageTableRoot == pageTable;
+#endif
+}
+
+#ifdef VM
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Handle a PageFaultException at "badVAddr".  Bring the page in if
+//	it is not resident, and with a TLB, load its translation (for a
+//	resident page that is all a "page fault" is -- a TLB miss, handled
+//	without taking the paging lock).  The faulting instruction is
+//	then simply retried.  A fault that continues a sequential scan
+//	fetches the pages after it too (see FaultAhead).
+//
+//	Returns FALSE if "badVAddr" is not in the address space at all,
+//	or is in a part of it nothing is in (see IsLegal).
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::PageFault(int badVAddr) {
+    unsigned int vpn = (unsigned) badVAddr / PageSize;
+
+    if (!IsLegal(vpn))
+        return FALSE;
+    SampleWorkingSet();
+    if (!PageEntry(vpn)->valid) {
+        int start = stats->totalTicks;
+
+        pagingLock->Acquire();
+        if (!PageEntry(vpn)->valid) {
+            LoadPage(vpn);
+            if (maxPrefetch > 0)
+                FaultAhead(vpn);
+        }
+        pagingLock->Release();
+        stats->pageFaultTicks += stats->totalTicks - start;
+    }
+#ifdef USE_TLB
+    tlbManager->Refill(this, vpn);
+#endif
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	Handle a ReadOnlyException at "badVAddr".  If the page is only
+//	read-only because its frame is shared with a Forked relative,
+//	give this process a copy of its own, writable, and the store is
+//	retried.  If nobody else maps the frame any more, it needn't even
+//	be copied.  With a TLB, the now writable entry is loaded into it,
+//	as PageFault does, so the retried store doesn't miss all over
+//	again -- Machine::ReadMem and WriteMem only retry twice.
+//
+//	Returns FALSE for a page that really is read-only (code).
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOnWrite(int badVAddr) {
+    unsigned int vpn = (unsigned) badVAddr / PageSize;
+    TranslationEntry *entry = pageTable->Lookup(vpn);
+
+    if (entry == NULL || !pageTable->Info(entry)->copyOnWrite)
+        return FALSE;
+
+    pagingLock->Acquire();
+    if (entry->valid && pageTable->Info(entry)->copyOnWrite) {  // again
+#ifdef USE_TLB
+        tlbManager->Invalidate(this, vpn);
+#endif
+        int shared = entry->physicalPage;
+        if (frameTable->RefCount(shared) > 1) {
+            frameTable->Pin(shared);
+            int frame = frameTable->Allocate(this, vpn);
+            bcopy(&(machine->mainMemory[shared * PageSize]),
+                  &(machine->mainMemory[frame * PageSize]), PageSize);
+            frameTable->Unpin(shared);
+            frameTable->Free(shared, this);
+            entry->physicalPage = frame;
+            frameTable->Unpin(frame);
+            DEBUG('v', "Process %d: page %d copied from frame %d to %d\n",
+                  spaceID, vpn, shared, frame);
+        }
+        entry->readOnly = FALSE;
+        entry->dirty = TRUE;    // differs from the backing store now
+        pageTable->Info(entry)->copyOnWrite = FALSE;
+        paging.minorFaults++;
+#ifdef USE_TLB
+        tlbManager->Refill(this, vpn);  // writable now, so that the
+                                        // store retried doesn't miss
+#endif
+    }
+    pagingLock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadPage
+// 	Get a frame for virtual page "vpn" (the frame table may evict
+//	another page to make room) and fill it.  A page that has been
+//	paged out comes back from swap.  Otherwise it is zeroed, and
+//	whatever parts of the code and initialized data segments fall in
+//	it are copied in; the rest (uninitData, stack, or the tail of a
+//	segment) stays zero.
+//
+//	A page entirely inside the code segment is mapped read-only, and
+//	shared through the text page cache with every other process
+//	running the same executable: if one of them has it in memory
+//	already, there is nothing to read.
+//
+//	With superpages on, the first fault in an untouched superpage
+//	loads all of it (see LoadSuperPage).
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::LoadPage(unsigned int vpn) {
+    int frame;
+    bool major;
+
+    AdjustFrameLimit();
+    if (machine->tlbSuperPages && !IsText(vpn) && LoadSuperPage(vpn))
+        return;
+    frame = FillPage(vpn, TRUE, &major);
+    if (major)
+        paging.majorFaults++;
+    else
+        paging.minorFaults++;
+
+    stats->numPageFaults++;
+    currentThread->accounting.numPageFaults++;
+    DEBUG('v', "Process %d: page %d loaded into frame %d\n",
+          spaceID, vpn, frame);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FillPage
+// 	The work of LoadPage for a single page "vpn": find it a frame --
+//	in the text page cache, or a new one -- fill it (from a mapped
+//	file, swap, or the executable), and map it.
+//	Returns the frame.  If "mayEvict" is FALSE, no other page is
+//	evicted to make room; if no frame is free, return -1, having done
+//	nothing.  A process at its frame limit gives up one of its own
+//	pages rather than take a free frame.
+//
+//	"*major" is set to whether the page had to be read from disk.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::FillPage(unsigned int vpn, bool mayEvict, bool *major) {
+    int pageStart = vpn * PageSize;
+    bool text = IsText(vpn);
+    int sector = text ? executable->file->HeaderSector() : -1;
+    int offset = noffH.code.inFileAddr + (pageStart - noffH.code.virtualAddr);
+    int frame = -1;
+
+    if (sector != -1)
+        frame = textCache->Find(sector, offset);
+    *major = FALSE;
+    if (frame != -1) {
+        frameTable->Share(frame, this, vpn);
+    } else {
+        if (!mayEvict)
+            frame = frameTable->AllocateRun(this, vpn, 0);
+        else if (pffControl && paging.residentPages >= paging.frameLimit)
+            frame = frameTable->AllocateLocal(this, vpn);
+        else
+            frame = frameTable->Allocate(this, vpn);
+        if (frame == -1)
+            return -1;
+        char *dest = &(machine->mainMemory[frame * PageSize]);
+
+        if (MappingOf(vpn) != NULL) {
+            ReadMapped(MappingOf(vpn), vpn, dest);
+            *major = TRUE;
+        } else if (SwapSlotOf(vpn) != -1) {
+            swapSpace->ReadPage(SwapSlotOf(vpn), dest);
+            paging.swapIns++;
+            *major = TRUE;
+        } else {
+            bzero(dest, PageSize);
+            if (LoadSegment(&noffH.code, vpn, dest))
+                *major = TRUE;
+            if (LoadSegment(&noffH.initData, vpn, dest))
+                *major = TRUE;
+        }
+        if (sector != -1)
+            frameTable->Cache(frame, sector, offset);
+        frameTable->Unpin(frame);
+    }
+    MapPage(vpn, frame, text);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapPage
+// 	Point the page table entry for "vpn" at "frame", which now holds
+//	the page's contents, unused and clean.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::MapPage(unsigned int vpn, int frame, bool readOnly) {
+    TranslationEntry *entry = PageEntry(vpn);
+
+    entry->physicalPage = frame;
+    entry->valid = TRUE;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    entry->readOnly = readOnly;
+    pageTable->Info(entry)->copyOnWrite = FALSE;
+    pageTable->Info(entry)->recentlyUsed = FALSE;
+    paging.residentPages++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSuperPage
+// 	If none of the SuperPageSpan-aligned run of pages around "vpn" has
+//	been touched -- nothing resident, nothing in swap, and no code
+//	that could be shared instead -- load the whole run into contiguous
+//	frames, so that the TLB can map it with a single entry.  Returns
+//	FALSE, having done nothing, if the run doesn't qualify, would take
+//	the process over its frame limit, or no run of frames is free;
+//	the page is then loaded on its own.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::LoadSuperPage(unsigned int vpn) {
+    unsigned int first = vpn & ~(SuperPageSpan - 1);
+    unsigned int i;
+    int frame;
+    bool major = FALSE;
+
+    if (first + SuperPageSpan > mmapBase || (pffControl &&
+        paging.residentPages + SuperPageSpan > paging.frameLimit))
+        return FALSE;
+    for (i = first; i < first + SuperPageSpan; i++) {
+        TranslationEntry *entry = pageTable->Lookup(i);
+        if ((entry != NULL && entry->valid) || SwapSlotOf(i) != -1 ||
+            IsText(i) || !IsLegal(i))
+            return FALSE;
+    }
+    frame = frameTable->AllocateRun(this, first, SuperPageOrder);
+    if (frame == -1)
+        return FALSE;
+
+    for (i = 0; i < SuperPageSpan; i++) {
+        char *dest = &(machine->mainMemory[(frame + i) * PageSize]);
+
+        bzero(dest, PageSize);
+        if (LoadSegment(&noffH.code, first + i, dest))
+            major = TRUE;
+        if (LoadSegment(&noffH.initData, first + i, dest))
+            major = TRUE;
+        MapPage(first + i, frame + i, FALSE);
+        frameTable->Unpin(frame + i);
+    }
+
+    if (major)
+        paging.majorFaults++;
+    else
+        paging.minorFaults++;
+    stats->numPageFaults++;
+    currentThread->accounting.numPageFaults++;
+    DEBUG('v', "Process %d: pages %d-%d loaded into frames %d-%d\n",
+          spaceID, first, first + SuperPageSpan - 1, frame,
+          frame + SuperPageSpan - 1);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsSuperPage
+// 	Return TRUE if the SuperPageSpan pages from "first" (aligned) on
+//	are all resident and writable, in consecutive frames, so that one
+//	TLB entry can translate them all.  Eviction or copy-on-write
+//	sharing of any one of them breaks the superpage up again.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::IsSuperPage(unsigned int first) {
+    TranslationEntry *head = pageTable->Lookup(first);
+
+    if ((first & (SuperPageSpan - 1)) || first + SuperPageSpan > numPages ||
+        head == NULL)
+        return FALSE;
+    for (unsigned int i = 0; i < SuperPageSpan; i++) {
+        TranslationEntry *entry = pageTable->Lookup(first + i);
+        if (entry == NULL || !entry->valid || entry->readOnly ||
+            pageTable->Info(entry)->copyOnWrite ||
+            entry->physicalPage != head->physicalPage + (int) i)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsText
+// 	Return TRUE if page "vpn" holds code and nothing else: it starts
+//	in the code segment, and either ends in it too, or whatever else
+//	it covers belongs to no segment.  With large pages, the last page
+//	of code is usually only partly code; if the data starts on a page
+//	of its own (as test/script arranges), that page can still be
+//	shared.  The stack is above every segment, so a page that reaches
+//	beyond them all might hold some of it, and doesn't count.
+//----------------------------------------------------------------------
+
+static bool
+Overlaps(Segment *seg, int start, int end) {
+    return seg->size > 0 && seg->virtualAddr < end &&
+           seg->virtualAddr + seg->size > start;
+}
+
+bool
+AddrSpace::IsText(unsigned int vpn) {
+    int pageStart = vpn * PageSize;
+    int pageEnd = pageStart + PageSize;
+    int codeEnd = noffH.code.virtualAddr + noffH.code.size;
+    int segmentsEnd = max(codeEnd, max(noffH.initData.virtualAddr +
+                                       noffH.initData.size,
+                                       noffH.uninitData.virtualAddr +
+                                       noffH.uninitData.size));
+
+    if (noffH.code.size <= 0 || pageStart < noffH.code.virtualAddr ||
+        pageStart >= codeEnd)
+        return FALSE;
+    return pageEnd <= codeEnd ||
+           (pageEnd <= segmentsEnd &&
+            !Overlaps(&noffH.initData, pageStart, pageEnd) &&
+            !Overlaps(&noffH.uninitData, pageStart, pageEnd));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InitPaging
+// 	Start out with no sequential streams, nothing fetched ahead, and
+//	no paging activity.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InitPaging() {
+    for (int i = 0; i < MaxPrefetchStreams; i++) {
+        streams[i].next = numPages;     // matches no fault
+        streams[i].size = 0;
+        streams[i].window = InitialPrefetch;
+        streams[i].lastFault = 0;
+    }
+    numFaults = 0;
+    lastSample = lastFault = 0;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FaultAhead
+// 	Page "vpn" has just been loaded on a fault.  If the fault is the
+//	one a sequential stream was expecting -- the page just past what
+//	it last fetched -- the program is scanning through memory, so
+//	fetch the next "window" pages of the stream now, before it faults
+//	on them one by one.  Otherwise the fault starts a new stream, in
+//	place of the one that has gone longest without continuing.
+//
+//	Several streams are kept, so that a loop reading one array while
+//	writing another (sort, matmult) is seen as two scans rather than
+//	as random access.  Each stream's window adapts to how much of what
+//	it fetched last time was used (see JudgeWindow).
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::FaultAhead(unsigned int vpn) {
+    PrefetchStream *stream = NULL;
+    PrefetchStream *oldest = &streams[0];
+    int fetched;
+
+    numFaults++;
+    for (int i = 0; i < MaxPrefetchStreams; i++) {
+        if (streams[i].next == vpn)
+            stream = &streams[i];
+        if (streams[i].lastFault < oldest->lastFault)
+            oldest = &streams[i];
+    }
+    if (stream == NULL) {       // not sequential, as far as we know yet
+        JudgeWindow(oldest);
+        oldest->next = vpn + 1;
+        oldest->window = InitialPrefetch;
+        oldest->lastFault = numFaults;
+        return;
+    }
+
+    JudgeWindow(stream);
+    stream->lastFault = numFaults;
+    stream->start = vpn + 1;
+    stream->size = min(stream->window, maxPrefetch);
+    fetched = Prefetch(stream->start, stream->size);
+    stream->next = stream->start + fetched;
+    DEBUG('v', "Process %d: fault on page %d, fetched ahead %d of pages "
+          "%d-%d\n", spaceID, vpn, fetched, stream->start,
+          stream->start + stream->size - 1);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::JudgeWindow
+// 	Count how many of the pages "stream" fetched ahead last time have
+//	been used since -- its hits -- and size its next window to match:
+//	double it if every page was used, halve it if fewer than half
+//	were.  A page evicted in the meantime was judged then.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::JudgeWindow(PrefetchStream *stream) {
+    int issued = 0, hits = 0;
+
+    for (unsigned int i = stream->start;
+         i < stream->start + stream->size && i < numPages; i++) {
+        TranslationEntry *entry = pageTable->Lookup(i);
+        PageInfo *info;
+
+        if (entry == NULL)
+            continue;
+        info = pageTable->Info(entry);
+        if (info->prefetched == NotPrefetched)
+            continue;
+        if (info->prefetched == Prefetched && entry->valid) {
+#ifdef USE_TLB
+            tlbManager->Sync(this, i);  // the TLB may know it's used
+#endif
+            if (entry->use)
+                info->prefetched = PrefetchUsed;
+        }
+        issued++;
+        if (info->prefetched == PrefetchUsed)
+            hits++;
+        info->prefetched = NotPrefetched;
+    }
+    stream->size = 0;
+    if (issued == 0)
+        return;
+
+    stats->numPrefetchHits += hits;
+    if (hits == issued)
+        stream->window = min(2 * stream->window, maxPrefetch);
+    else if (2 * hits < issued)
+        stream->window = max(stream->window / 2, 1);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Prefetch
+// 	Load whichever of the "count" pages from "first" on are not
+//	resident, without evicting anything for them: fetching ahead
+//	only uses memory that is free anyway, and that the process's
+//	frame limit allows it.  Returns how many pages were covered,
+//	which is fewer than "count" if frames ran out.
+//
+//	Non-resident pages that come from consecutive places -- swap
+//	slots in a row, or (neighbouring) parts of the executable -- are
+//	read together, with one disk request, into a buffer, and copied
+//	to their frames from there.  Code pages go through the text page
+//	cache, and pages of mapped files are read from the file, one at a
+//	time, as they would be on a fault.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Prefetch(unsigned int first, int count) {
+    unsigned int end = min(first + count, numPages);
+    unsigned int vpn = first;
+    int frames[MaxPrefetch];
+    char *buffer = NULL;
+    int n, wanted;
+    bool major;
+
+    while (vpn < end) {
+        if (IsResident(vpn)) {
+            vpn++;
+            continue;
+        }
+        if (pffControl && paging.residentPages >= paging.frameLimit)
+            break;
+        if (!IsLegal(vpn))
+            break;              // off the end of the heap or a mapped file
+        if (IsText(vpn) || vpn >= mmapBase) {
+            if (FillPage(vpn, FALSE, &major) == -1)
+                break;
+            InfoOf(vpn++)->prefetched = Prefetched;
+            stats->numPrefetches++;
+            continue;
+        }
+
+        // the run of pages that can be read together
+        for (n = 1; vpn + n < min(end, mmapBase) && !IsResident(vpn + n) &&
+                    !IsText(vpn + n) && IsLegal(vpn + n); n++) {
+            int slot = SwapSlotOf(vpn + n - 1);
+            if (slot == -1 ? SwapSlotOf(vpn + n) != -1
+                           : SwapSlotOf(vpn + n) != slot + 1)
+                break;
+        }
+        if (pffControl)
+            n = min(n, paging.frameLimit - paging.residentPages);
+        wanted = n;
+        for (int i = 0; i < n; i++) {
+            frames[i] = frameTable->AllocateRun(this, vpn + i, 0);
+            if (frames[i] == -1) {
+                n = i;
+                break;
+            }
+        }
+        if (n == 0)
+            break;
+
+        if (buffer == NULL)
+            buffer = new char[count * PageSize];
+        if (SwapSlotOf(vpn) != -1) {
+            swapSpace->ReadPages(SwapSlotOf(vpn), n, buffer);
+            paging.swapIns += n;
+        } else {
+            bzero(buffer, n * PageSize);
+            LoadSegment(&noffH.code, vpn, buffer, n);
+            LoadSegment(&noffH.initData, vpn, buffer, n);
+        }
+        for (int i = 0; i < n; i++) {
+            bcopy(&buffer[i * PageSize],
+                  &(machine->mainMemory[frames[i] * PageSize]), PageSize);
+            MapPage(vpn + i, frames[i], FALSE);
+            frameTable->Unpin(frames[i]);
+            InfoOf(vpn + i)->prefetched = Prefetched;
+        }
+        stats->numPrefetches += n;
+        vpn += n;
+        if (n < wanted)         // out of free frames
+            break;
+    }
+    delete[] buffer;
+    return vpn - first;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SampleWorkingSet
+// 	Every WSSampleInterval ticks of the process's own (user) time,
+//	count the resident pages whose use bits are set -- the pages it
+//	has used since the last sample, its working set -- and clear the
+//	bits for the next interval.  Which pages were in the set is kept,
+//	for Trim.
+//
+//	Called on every page fault (with a TLB, every TLB miss), which is
+//	as often as the kernel gets to look.  Clearing use bits is done
+//	with interrupts off, rather than under the paging lock, so that a
+//	TLB miss needn't wait for a page being read in for someone else.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SampleWorkingSet() {
+    ThreadStats st;
+    IntStatus oldLevel;
+    int used = 0;
+
+    currentThread->GetStats(&st);
+    if (st.userTicks - lastSample < WSSampleInterval)
+        return;
+
+    oldLevel = interrupt->SetLevel(IntOff);
+#ifdef USE_TLB
+    tlbManager->Sync();         // get the latest use bits
+#endif
+    for (TranslationEntry *entry = pageTable->Next(NULL); entry != NULL;
+         entry = pageTable->Next(entry)) {
+        PageInfo *info = pageTable->Info(entry);
+
+        info->recentlyUsed = entry->valid && entry->use;
+        if (!info->recentlyUsed)
+            continue;
+        used++;
+        entry->use = FALSE;
+        frameTable->Touched(entry->physicalPage);
+        if (info->prefetched == Prefetched)     // a hit, for FaultAhead
+            info->prefetched = PrefetchUsed;
+    }
+    paging.workingSet = used;
+    lastSample = st.userTicks;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AdjustFrameLimit
+// 	The page-fault-frequency controller, run on every fault that
+//	loads a page.  If the process has faulted again within
+//	PFFInterval ticks of its own time, it hasn't enough frames: raise
+//	its limit by one.  If it has gone longer, it has more than it
+//	needs: drop the pages it hasn't used lately, and lower the limit
+//	to what is left (plus the page being loaded).
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::AdjustFrameLimit() {
+    ThreadStats st;
+    int interval;
+
+    currentThread->GetStats(&st);
+    interval = st.userTicks - lastFault;
+    lastFault = st.userTicks;
+    if (!pffControl)
+        return;
+
+    if (interval < PFFInterval) {
+        if (paging.frameLimit < frameTable->NumFrames())
+            paging.frameLimit++;
+    } else {
+        Trim();
+        paging.frameLimit = max(MinFrameLimit, paging.residentPages + 1);
+    }
+    DEBUG('v', "Process %d: %d ticks since the last fault, frame limit %d\n",
+          spaceID, interval, paging.frameLimit);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Trim
+// 	Evict every resident page that was used neither in the last
+//	sample interval nor since, and give back its frame.  Pages shared
+//	with another process, or pinned, stay.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Trim() {
+#ifdef USE_TLB
+    tlbManager->Sync();         // get the latest use bits
+#endif
+    for (TranslationEntry *entry = pageTable->Next(NULL); entry != NULL;
+         entry = pageTable->Next(entry))
+        if (entry->valid && !entry->use &&
+            !pageTable->Info(entry)->recentlyUsed)
+            frameTable->Drop(entry->physicalPage);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrintPagingStats
+// 	Print the process's paging activity, as it exits.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PrintPagingStats() {
+    printf("Process %d paging: %d resident, %d major faults, %d minor "
+           "faults, %d swap reads, %d swap writes, working set %d, "
+           "frame limit %d\n", spaceID, paging.residentPages,
+           paging.majorFaults, paging.minorFaults, paging.swapIns,
+           paging.swapOuts, paging.workingSet, paging.frameLimit);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Evict
+// 	Page "vpn" is losing its frame.  If it has been written since it
+//	was loaded, save it in swap first (it keeps the same slot from
+//	then on); a clean page can simply be loaded again from wherever
+//	it came from -- swap, the executable, or zeros.
+//
+//	Called by the frame table, with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Evict(unsigned int vpn) {
+    TranslationEntry *entry = PageEntry(vpn);
+    PageInfo *info = pageTable->Info(entry);
+
+    ASSERT(entry->valid);
+#ifdef USE_TLB
+    tlbManager->Invalidate(this, vpn);  // its bits may be newer than ours
+#endif
+    entry->valid = FALSE;       // before we might block on the disk
+    if (info->prefetched == Prefetched) // used or wasted -- decide now
+        info->prefetched = entry->use ? PrefetchUsed : NotPrefetched;
+    if (entry->dirty)
+        CleanPage(vpn);
+    entry->physicalPage = -1;
+    entry->use = FALSE;
+    info->copyOnWrite = FALSE;  // only unshared frames are evicted
+    paging.residentPages--;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CleanPage
+// 	If page "vpn" has been written since it was last saved, write it
+//	out to its swap slot (allocating one the first time), or to its
+//	file if it is mapped, so that it can later be evicted without
+//	another write.
+//
+//	Called by the frame table, with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CleanPage(unsigned int vpn) {
+    TranslationEntry *entry = PageEntry(vpn);
+
+#ifdef USE_TLB
+    tlbManager->Sync(this, vpn);        // the TLB may know it's dirty
+#endif
+    if (!entry->dirty)
+        return;
+    if (MappingOf(vpn) != NULL) {       // back to the file, not swap
+        entry->dirty = FALSE;
+        WriteMapped(MappingOf(vpn), vpn);
+        return;
+    }
+    PageInfo *info = pageTable->Info(entry);
+
+    if (info->swapSlot == -1) {
+        info->swapSlot = swapSpace->Allocate();
+        if (info->swapSlot == -1) {
+            printf("Out of swap space, paging out page %d of process %d\n",
+                   vpn, spaceID);
+            ASSERT(FALSE);
+        }
+    }
+    entry->dirty = FALSE;       // writes from now on must be saved again
+    swapSpace->WritePage(info->swapSlot,
+                         &(machine->mainMemory[entry->physicalPage * PageSize]));
+    paging.swapOuts++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReleasePages
+// 	Give back every frame and swap slot the address space holds,
+//	writing dirty pages of mapped files back to them first.
+//	Called when the process exits -- its AddrSpace may be kept around
+//	afterwards for Join -- and again, harmlessly, by the destructor.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReleasePages() {
+    pagingLock->Acquire();
+    for (unsigned int i = mmapBase; i < numPages; i++)
+        if (mapOf[i - mmapBase] != NULL)        // saves dirty pages
+            RemoveMapping(mapOf[i - mmapBase]);
+    for (int i = 0; i < MaxPrefetchStreams; i++)
+        JudgeWindow(&streams[i]);       // count the last hits
+#ifdef USE_TLB
+    tlbManager->InvalidateSpace(this);  // our ASID may be reused
+#endif
+    for (TranslationEntry *entry = pageTable->Next(NULL); entry != NULL;
+         entry = pageTable->Next(entry))
+        ReleasePage(entry->virtualPage);
+    pagingLock->Release();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReleasePage
+// 	Give back the frame and swap slot page "vpn" holds, if any; its
+//	contents are gone.  The caller has taken it out of the TLB.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReleasePage(unsigned int vpn) {
+    TranslationEntry *entry = pageTable->Lookup(vpn);
+    PageInfo *info;
+
+    if (entry == NULL)          // never touched
+        return;
+    info = pageTable->Info(entry);
+    if (entry->valid) {
+        frameTable->Free(entry->physicalPage, this);
+        entry->valid = FALSE;
+        entry->physicalPage = -1;
+        info->copyOnWrite = FALSE;
+        paging.residentPages--;
+    }
+    if (info->swapSlot != -1) {
+        swapSpace->Free(info->swapSlot);
+        info->swapSlot = -1;
+    }
+    info->prefetched = NotPrefetched;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsLegal
+// 	Return TRUE if the program may touch page "vpn": it is in the
+//	address space, and not in the unused part of the heap region,
+//	past the break, nor a page of the region for mapped files that
+//	nothing is mapped in.  A stack that overflows into the heap
+//	region, beyond the break, is caught this way too.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::IsLegal(unsigned int vpn) {
+    if (vpn >= numPages)
+        return FALSE;
+    if (vpn >= (unsigned) divRoundUp(brk, PageSize) && vpn < stackBase)
+        return FALSE;
+    return vpn < mmapBase || MappingOf(vpn) != NULL;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Sbrk
+// 	Move the break -- the end of the heap -- by "increment" bytes,
+//	which may be negative, and return where it was.  Pages the heap
+//	grows into are zero-filled on demand, like the rest of the
+//	uninitialized data; pages it shrinks out of are freed, and read
+//	as zeros if it grows back over them.  Returns -1, leaving the
+//	break alone, if it would leave the region between the data and
+//	the stack.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Sbrk(int increment) {
+    int old = brk;
+    int newBrk = brk + increment;
+
+    if (newBrk < (int) (heapBase * PageSize) ||
+        newBrk > (int) (stackBase * PageSize))
+        return -1;
+    pagingLock->Acquire();
+    for (int vpn = divRoundUp(newBrk, PageSize);
+         vpn < divRoundUp(old, PageSize); vpn++) {
+#ifdef USE_TLB
+        tlbManager->Invalidate(this, vpn);
+#endif
+        ReleasePage(vpn);
+    }
+    brk = newBrk;
+    pagingLock->Release();
+    DEBUG('v', "Process %d: break moved from 0x%x to 0x%x\n", spaceID,
+          old, newBrk);
+    return old;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Copy the part of segment "seg" that overlaps the "count" virtual
+//	pages from "vpn" on from the executable into "dest", which holds
+//	those pages, one after the other -- a single read, however many
+//	pages it covers.  Returns FALSE if the segment doesn't overlap
+//	them, so there was nothing to read.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::LoadSegment(Segment *seg, unsigned int vpn, char *dest,
+                       int count) {
+    int pageStart = vpn * PageSize;
+    int start = max(seg->virtualAddr, pageStart);
+    int end = min(seg->virtualAddr + seg->size,
+                  pageStart + count * PageSize);
+
+    if (seg->size <= 0 || start >= end)
+        return FALSE;
+    executable->file->ReadAt(dest + (start - pageStart), end - start,
+                       seg->inFileAddr + (start - seg->virtualAddr));
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Map
+// 	Map "length" bytes of the open "file", from "offset" on -- which
+//	must be a multiple of the page size -- into the first free run of
+//	pages big enough in the region above the stack.  Nothing is read
+//	yet: pages are faulted in from the file as they are touched.
+//	Returns the virtual address of the mapping, or -1 if the request
+//	makes no sense or there is no room.
+//
+//	The mapping takes its own copy of the file header, so it needn't
+//	be undone before the file is closed.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Map(OpenFile *file, int offset, int length) {
+    int fileLength, pages, first;
+    Mapping *m;
+
+    if (length <= 0 || offset < 0 || offset % PageSize != 0)
+        return -1;
+    file->WriteBack();          // so the header on disk is current
+    fileLength = file->Length();
+    if (offset >= fileLength)
+        return -1;
+    pages = divRoundUp(length, PageSize);
+
+    pagingLock->Acquire();
+    first = FindMapRun(pages);
+    if (first == -1) {
+        pagingLock->Release();
+        return -1;
+    }
+
+    m = new Mapping;
+    m->shm = NULL;
+    m->hdr = new FileHeader;
+    m->hdr->FetchFrom(file->HeaderSector());
+    m->offset = offset;
+    m->length = min(length, fileLength - offset);
+    m->first = first;
+    m->numPages = pages;
+    for (int i = 0; i < pages; i++)
+        mapOf[first + i - mmapBase] = m;
+    pagingLock->Release();
+
+    DEBUG('v', "Process %d: %d bytes at offset %d mapped at pages %d-%d\n",
+          spaceID, length, offset, first, first + pages - 1);
+    return first * PageSize;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::FindMapRun
+// 	Return the first page of the lowest run of "pages" pages in the
+//	region for mapped files that nothing is mapped in, or -1 if there
+//	is no such run.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
 
-int AddrSpace::getFileDescriptor(OpenFile * openfile)
-{
-    for (int i=3;i<10;i++)
-    {
-        if (fileDescriptor[i] == NULL)
-        {
-            fileDescriptor[i] = openfile;
-            return i;
-        }  //if
-    }  //for
+int
+AddrSpace::FindMapRun(int pages) {
+    unsigned int first, i;
+
+    for (first = mmapBase; first + pages <= numPages; first += i + 1) {
+        for (i = 0; i < (unsigned) pages && mapOf[first + i - mmapBase] == NULL;
+             i++)
+            ;
+        if (i == (unsigned) pages)
+            return first;
+    }
     return -1;
 }
 
-OpenFile* AddrSpace::getFileId(int fd)
-{
-    return fileDescriptor[fd];
+//----------------------------------------------------------------------
+// AddrSpace::Attach
+// 	Map the shared memory segment called "key" into the first free run
+//	of pages big enough in the region above the stack -- first making
+//	a new one, "size" bytes long, if "create" is set.  Returns the
+//	virtual address of the segment, or -1 if there is no such segment
+//	(or, if "create", there already is one), or no room.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Attach(int key, int size, bool create) {
+    ShmSegment *seg;
+    int first;
+
+    pagingLock->Acquire();
+    if (create) {
+        if (size <= 0 || (first = FindMapRun(divRoundUp(size, PageSize))) == -1)
+            seg = NULL;
+        else
+            seg = shmTable->Create(key, size, this);
+    } else {
+        seg = shmTable->Find(key);
+        if (seg != NULL && (first = FindMapRun(seg->numPages)) == -1)
+            seg = NULL;
+    }
+    if (seg == NULL) {
+        pagingLock->Release();
+        return -1;
+    }
+    MapSegment(seg, first);
+    pagingLock->Release();
+    return first * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapSegment
+// 	Map every page of shared memory segment "seg" from page "first"
+//	on, which are free, taking a reference to each of its frames.
+//	The pages are resident from the start, so touching them never
+//	faults (except to refill the TLB).
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::MapSegment(ShmSegment *seg, unsigned int first) {
+    Mapping *m = new Mapping;
+
+    m->shm = seg;
+    m->hdr = NULL;
+    m->offset = 0;
+    m->length = seg->numPages * PageSize;
+    m->first = first;
+    m->numPages = seg->numPages;
+    for (int i = 0; i < seg->numPages; i++) {
+        frameTable->Share(seg->frames[i], this, first + i);
+        MapPage(first + i, seg->frames[i], FALSE);
+        mapOf[first + i - mmapBase] = m;
+    }
+    shmTable->Attach(seg);
+    DEBUG('v', "Process %d: shared segment %d attached at pages %d-%d\n",
+          spaceID, seg->key, first, first + seg->numPages - 1);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unmap
+// 	Undo the mapping that starts at virtual address "addr", writing
+//	its dirty pages back to the file -- or, if "segment", detach the
+//	shared memory segment there.  Returns FALSE if no mapping of that
+//	kind starts there.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Unmap(int addr, bool segment) {
+    unsigned int vpn = (unsigned) addr / PageSize;
+    Mapping *m;
+
+    if (addr % PageSize != 0 || vpn >= numPages)
+        return FALSE;
+    pagingLock->Acquire();
+    m = MappingOf(vpn);
+    if (m == NULL || m->first != vpn || (m->shm != NULL) != segment) {
+        pagingLock->Release();
+        return FALSE;
+    }
+    RemoveMapping(m);
+    pagingLock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::RemoveMapping
+// 	Unmap every page of "m", saving the dirty ones to the file and
+//	freeing their frames, and forget the mapping.  For a shared memory
+//	segment, there is nothing to save: the frames are only given up by
+//	this process, and by the segment once nobody has it attached.
+//
+//	Called with the paging lock held.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::RemoveMapping(Mapping *m) {
+    for (unsigned int i = m->first; i < m->first + m->numPages; i++) {
+        TranslationEntry *entry = pageTable->Lookup(i);
+
+        if (entry != NULL && entry->valid) {
+#ifdef USE_TLB
+            tlbManager->Invalidate(this, i);    // it may know it's dirty
+#endif
+            entry->valid = FALSE;
+            if (entry->dirty && m->shm == NULL) {
+                entry->dirty = FALSE;
+                WriteMapped(m, i);
+            }
+            frameTable->Free(entry->physicalPage, this);
+            entry->physicalPage = -1;
+            paging.residentPages--;
+        }
+        if (entry != NULL)
+            pageTable->Info(entry)->prefetched = NotPrefetched;
+        mapOf[i - mmapBase] = NULL;
+    }
+    DEBUG('v', "Process %d: pages %d-%d unmapped\n", spaceID, m->first,
+          m->first + m->numPages - 1);
+    if (m->shm != NULL)
+        shmTable->Detach(m->shm);
+    delete m->hdr;
+    delete m;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadMapped, AddrSpace::WriteMapped
+// 	Move page "vpn" of mapping "m" between the file and memory -- into
+//	"dest", or out of the page's frame.  The part of the page past the
+//	end of the file is zeroed on the way in, and left behind on the
+//	way out.  A mapping can end partway through a sector, so the last
+//	sector on the way out is read, patched and written back, rather
+//	than overwriting the rest of it with those zeros.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReadMapped(Mapping *m, unsigned int vpn, char *dest) {
+    int start = (vpn - m->first) * PageSize;
+    int bytes = max(0, min(PageSize, m->length - start));
+
+    m->hdr->TransferSectors(m->offset + start, bytes, dest, FALSE);
+    bzero(dest + bytes, PageSize - bytes);
+}
+
+void
+AddrSpace::WriteMapped(Mapping *m, unsigned int vpn) {
+    int start = (vpn - m->first) * PageSize;
+    int bytes = max(0, min(PageSize, m->length - start));
+    int whole = bytes - bytes % SectorSize;
+    char *from = &(machine->mainMemory[PageEntry(vpn)->physicalPage * PageSize]);
+
+    m->hdr->TransferSectors(m->offset + start, whole, from, TRUE);
+    if (whole < bytes) {
+        char buf[SectorSize];
+        int sector = m->hdr->ByteToSector(m->offset + start + whole);
+
+        synchDisk->ReadSector(sector, buf);
+        bcopy(from + whole, buf, bytes - whole);
+        synchDisk->WriteSector(sector, buf);
+    }
+}
+
+#endif // VM
+
+
+//----------------------------------------------------------------------
+// AddrSpace::getFileDescriptor
+// 	Return the lowest free file descriptor, now naming "entry" -- an
+//	entry in the open-file table, from FileTable::Open -- or -1 if
+//	the process has as many files open as it may.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::getFileDescriptor(OpenFileEntry *entry) {
+    return fds->Add(entry);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::getFileId
+// 	Return the open file "fd" names, or NULL if it isn't open or
+//	doesn't name a file.  Its seek offset is shared with any other
+//	descriptor on the same entry.
+//----------------------------------------------------------------------
+
+OpenFile *
+AddrSpace::getFileId(int fd) {
+    OpenFileEntry *entry = fds->Get(fd);
+
+    return (entry == NULL || entry->pipe != NULL || entry->console)
+           ? NULL : entry->file;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::getFileEntry
+// 	Return the open-file table entry "fd" names -- a file, a pipe or
+//	the console -- or NULL if it isn't open.
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+AddrSpace::getFileEntry(int fd) {
+    return fds->Get(fd);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InheritStdio
+// 	Make stdin, stdout and stderr name what they do in "parent", the
+//	process that Exec'd this one, so that a shell can run a program
+//	with them redirected.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InheritStdio(AddrSpace *parent) {
+    fds->Inherit(parent->fds, 3);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::releaseFileDescriptor
+// 	Close "fd".  The file itself is closed when no descriptor, in any
+//	process, names its entry.  Return FALSE if "fd" wasn't open.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::releaseFileDescriptor(int fd) {
+    OpenFileEntry *entry = fds->Remove(fd);
+
+    if (entry == NULL)
+        return FALSE;
+    fileTable->Release(entry);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CloseFiles
+// 	Close every descriptor the process still has open, when it exits.
+//	The AddrSpace stays around for Join, so this can't wait for the
+//	destructor.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CloseFiles() {
+    fds->CloseAll();
 }
 
-void AddrSpace::releaseFileDescriptor(int fd)
-{
-    fileDescriptor[fd] = NULL;
+//----------------------------------------------------------------------
+// AddrSpace::PinUserPage
+// 	Return where in physical memory the user byte at "addr" is, after
+//	faulting its page in if need be (and, if "writing", making it
+//	writable), and keep the page in that frame until UnpinUserPage.
+//	The disk can then move data straight in or out of the page while
+//	this thread waits for it.  Return NULL if "addr" isn't a legal
+//	address.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::PinUserPage(int addr, bool writing) {
+    ExceptionType exception;
+    int physAddr;
+
+#ifdef VM
+    if (!IsLegal((unsigned) addr / PageSize))
+        return NULL;                    // not something to fault in
+#endif
+    // as in Machine::ReadMem, a page may need faulting in and then
+    // copying on write -- but here the kernel does it itself, so that
+    // a bad address fails the system call, not the whole machine.
+    // Keep at it for as long as that succeeds: the page may be taken
+    // again while PageFault waits for the disk.
+    for (;;) {
+#ifdef VM
+        pagingLock->Acquire();          // so it can't go before it's pinned
+#endif
+        exception = machine->Translate(addr, &physAddr, 1, writing);
+#ifdef VM
+        if (exception == NoException)
+            frameTable->Pin(physAddr / PageSize);
+        pagingLock->Release();
+#endif
+        if (exception == NoException)
+            return &(machine->mainMemory[physAddr]);
+#ifdef VM
+        if (exception == PageFaultException && PageFault(addr))
+            continue;
+        if (exception == ReadOnlyException && CopyOnWrite(addr))
+            continue;
+#endif
+        break;
+    }
+    return NULL;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::UnpinUserPage
+// 	Let the page PinUserPage returned "where" in be evicted again.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::UnpinUserPage(char *where) {
+#ifdef VM
+    pagingLock->Acquire();
+    frameTable->Unpin((where - machine->mainMemory) / PageSize);
+    pagingLock->Release();
+#endif
+}
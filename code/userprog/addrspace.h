@@ -15,17 +15,115 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "noff.h"
+#include "pagetable.h"
 
 #define UserStackSize        1024    // increase this as necessary!
 
 #define MAX_USERPOCESSES 256
 extern bool ThreadMap[MAX_USERPOCESSES];
 
+class FileHeader;
+class FdTable;
+class OpenFileEntry;
+
+#ifdef VM
+// An executable file, shared by the address spaces forked from the
+// one that Exec'd it; the last of them to go away closes it.
+
+class SharedExecutable {
+public:
+    SharedExecutable(OpenFile *f) { file = f; refCount = 1; }
+    ~SharedExecutable() { delete file; }
+
+    OpenFile *file;
+    int refCount;
+};
+
+#define DefaultPrefetch     8   // most pages fetched ahead of a fault
+#define MaxPrefetch         32  // ... as -vp may set it
+#define InitialPrefetch     2   // window of a newly detected stream
+#define MaxPrefetchStreams  4   // sequential scans tracked per process
+
+extern int maxPrefetch;         // 0 turns fault-ahead off
+
+// A sequential scan through an address space, as seen by its page
+// faults: each fault on the page just past the previous one's window
+// continues the stream, and fetches the next "window" pages ahead.
+
+class PrefetchStream {
+public:
+    unsigned int next;          // the fault that would continue it
+    unsigned int start;         // the pages fetched ahead last time,
+    int size;                   // not yet judged
+    int window;                 // how many to fetch next time
+    int lastFault;              // when it last continued, for
+                                // replacement
+};
+
+#define WSSampleInterval    1000    // user ticks between working-set
+                                    // samples
+#define PFFInterval         1000    // a process faulting more often than
+                                    // this (in user ticks) is given
+                                    // another frame
+#define InitialFrameLimit   8
+#define MinFrameLimit       4
+
+extern bool pffControl;         // FALSE: no per-process frame limits
+
+// Paging activity of one address space.  A major fault had to read
+// the page from disk; a minor one didn't (a zero-filled page, a code
+// page already in the text page cache, a copy-on-write copy).
+
+class PagingStats {
+public:
+    PagingStats();              // all counters start at zero
+
+    int residentPages;          // frames mapped right now
+    int majorFaults;
+    int minorFaults;
+    int swapIns;                // pages read from swap
+    int swapOuts;               // pages written to swap
+    int workingSet;             // pages used in the last sample interval
+    int frameLimit;             // frames the PFF controller allows
+};
+
+#define MmapRegionSize  (64 * 1024)     // bytes of address space, above
+                                        // the stack, for mapped files
+#define HeapRegionSize  (128 * 1024)    // ... below the stack, for Sbrk
+
+// A file mapped into an address space by Mmap: "numPages" pages from
+// "first" on hold its bytes from "offset" on.  Pages are read from the
+// file's data sectors when first touched, and written back to them --
+// never to swap -- when dirty.  Mapped bytes beyond the end of the
+// file read as zeros, and are not written back.
+//
+// A shared memory segment (see shm.h) attached by the process is
+// recorded the same way; its pages are resident as long as it is.
+
+class ShmSegment;
+
+class Mapping {
+public:
+    ShmSegment *shm;            // if not NULL, the segment mapped, and
+                                // there is no file
+    FileHeader *hdr;            // where the file's sectors are
+    int offset;                 // in the file, of the first page
+    int length;                 // bytes of the file behind the mapping
+    unsigned int first;         // first virtual page
+    int numPages;
+};
+#endif
+
 class AddrSpace {
 public:
     AddrSpace(OpenFile *executable);    // Create an address space,
     // initializing it with the program
     // stored in the file "executable"
+#ifdef VM
+    AddrSpace(AddrSpace *parent);       // Create a copy-on-write copy
+    // of "parent", for Fork
+#endif
     ~AddrSpace();            // De-allocate an address space
 
     void InitRegisters();        // Initialize user-level CPU registers,
@@ -33,23 +131,139 @@ public:
 
     void SaveState();            // Save/restore address space-specific
     void RestoreState();        // info on a context switch
+    bool IsLoaded();            // is this the space the machine
+    // is translating for right now?
     int getSpaceID() { return spaceID; }
 
-    int getFileDescriptor(OpenFile *openfile);
+#ifdef VM
+    bool PageFault(int badVAddr);    // handle a page fault (or TLB
+    // miss) at "badVAddr"; FALSE if it
+    // is outside the address space
+    bool CopyOnWrite(int badVAddr);  // handle a ReadOnlyException at
+    // "badVAddr"; FALSE if the page
+    // really is read-only
+    void ReleasePages();        // give back every frame and swap slot
+
+    // Called by the frame table, with the paging lock held
+    TranslationEntry *PageEntry(unsigned int vpn) {
+        return pageTable->Entry(vpn);
+    }
+    void Evict(unsigned int vpn);       // page vpn loses its frame
+    void CleanPage(unsigned int vpn);   // write vpn back if dirty
+
+    // Called by the TLB manager
+    bool IsSuperPage(unsigned int first);   // can one TLB entry map the
+    // SuperPageSpan pages from first on?
+
+    int Map(OpenFile *file, int offset, int length);
+    // map "length" bytes of "file" from
+    // "offset" on; return the address, or
+    // -1 if it can't be done
+    int Sbrk(int increment);    // move the break; return the old one,
+    // or -1 if it can't go there
+    bool Unmap(int addr, bool segment);
+    // undo the Map (or Attach, if
+    // "segment") that returned "addr"
+    int Attach(int key, int size, bool create);
+    // map shared memory segment "key"
+    // (creating it "size" bytes long
+    // first, if "create"); return the
+    // address, or -1 if it can't be done
 
-    void releaseFileDescriptor(int fd);
+    void GetPagingStats(PagingStats *st) { *st = paging; }
+    void PrintPagingStats();    // one line, when the process exits
+#endif
 
-    OpenFile *getFileId(int fd);
+    int getFileDescriptor(OpenFileEntry *entry);   // the lowest free
+    // descriptor now names "entry"; -1 if
+    // the process has too many files open
+
+    bool releaseFileDescriptor(int fd); // close "fd"; FALSE if it
+    // wasn't open
+
+    OpenFile *getFileId(int fd);    // NULL if "fd" isn't open
+    OpenFileEntry *getFileEntry(int fd);    // ... or isn't a file,
+    // but a pipe or the console
+
+    void InheritStdio(AddrSpace *parent);   // Exec: 0, 1 and 2 name
+    // what they do in "parent"
+
+    void CloseFiles();          // close every descriptor, on Exit
+
+    char *PinUserPage(int addr, bool writing);  // where user byte
+    // "addr" is in physical memory, its
+    // page held there; NULL if illegal
+    void UnpinUserPage(char *where);    // let that page go again
 
 private:
-    TranslationEntry *pageTable;    // Assume linear page table translation
-    // for now!
+    PageTable *pageTable;       // linear, two-level or hashed, as built
     unsigned int numPages;        // Number of pages in the virtual
     // address space
 
     int spaceID;
+    bool AllocateSpaceID();     // pick a free spaceID; FALSE if none
+
+    FdTable *fds;               // this process's file descriptors
+
+#ifdef VM
+    SharedExecutable *executable;   // where non-resident code and
+    NoffHeader noffH;           // data pages come from
+    PageInfo *InfoOf(unsigned int vpn) {    // what we know about
+        return pageTable->Info(PageEntry(vpn)); // page "vpn" (giving it
+    }                                           // an entry if need be)
+    int SwapSlotOf(unsigned int vpn) {  // its copy in swap, or -1
+        TranslationEntry *entry = pageTable->Lookup(vpn);
+        return (entry == NULL) ? -1 : pageTable->Info(entry)->swapSlot;
+    }
+    void LoadPage(unsigned int vpn);    // bring page "vpn" in
+    bool LoadSuperPage(unsigned int vpn);   // ... and the rest of its
+    // superpage, if it can
+    bool IsText(unsigned int vpn);      // wholly inside the code segment?
+    int FillPage(unsigned int vpn, bool mayEvict, bool *major);
+    // give page "vpn" a frame and its
+    // contents; -1 if !mayEvict and
+    // no frame is free
+    void MapPage(unsigned int vpn, int frame, bool readOnly);
+    bool LoadSegment(Segment *seg, unsigned int vpn, char *dest,
+                     int count = 1);    // ... over "count" pages;
+    // FALSE if none of it is there
+
+    unsigned int heapBase;      // first page of the region for Sbrk
+    int brk;                    // the break: where the heap ends
+    unsigned int stackBase;     // first page of the stack
+    unsigned int mmapBase;      // first page of the region for Map
+    Mapping **mapOf;            // per page of that region: the mapping
+    // it belongs to, or NULL
+    Mapping *MappingOf(unsigned int vpn) {
+        return (vpn >= mmapBase) ? mapOf[vpn - mmapBase] : NULL;
+    }
+    void ReadMapped(Mapping *m, unsigned int vpn, char *dest);
+    void WriteMapped(Mapping *m, unsigned int vpn);
+    void RemoveMapping(Mapping *m);
+    bool IsLegal(unsigned int vpn);     // may the program touch it?
+    void ReleasePage(unsigned int vpn); // give back its frame and swap
+    // slot
+    int FindMapRun(int pages);  // first page of a free run, or -1
+    void MapSegment(ShmSegment *seg, unsigned int first);
+
+    PagingStats paging;
+    int lastSample;             // user ticks at the last sample
+    int lastFault;              // ... at the last fault
+    void SampleWorkingSet();    // if it is time to
+    void AdjustFrameLimit();    // on a fault, by its frequency
+    void Trim();                // drop pages not recently used
 
-    OpenFile *fileDescriptor[10];
+    PrefetchStream streams[MaxPrefetchStreams];
+    int numFaults;              // demand faults so far
+    void InitPaging();          // no streams, no counts yet
+    void FaultAhead(unsigned int vpn);  // after a fault on vpn
+    int Prefetch(unsigned int first, int count);
+    void JudgeWindow(PrefetchStream *stream);
+    bool IsResident(unsigned int vpn) {
+        TranslationEntry *entry = pageTable->Lookup(vpn);
+        return entry != NULL && entry->valid;
+    }
+#endif
 
 };
 
@@ -27,9 +27,27 @@
 #include "progtest.h"
 #include "ctype.h"
 #include "ftest.h"
+#include "trace.h"
+#include "pipe.h"
 
 AddrSpace *space;
 
+// Names of the system calls, indexed by SC_ code, for event traces.
+static char *syscallNames[] = {"Halt", "Exit", "Exec", "Join", "Create",
+                               "Open", "Read", "Write", "Close", "Fork",
+                               "Yield", "Sleep", "ProcStat", "MemStat",
+                               "Mmap", "Munmap", "ReadV", "WriteV",
+                               "Pipe", "Dup", "ShmCreate", "ShmAttach",
+                               "ShmDetach", "FutexWait", "FutexWake",
+                               "Sbrk"};
+
+static char *
+SyscallName(int type) {
+    if (type < 0 || type >= (int) (sizeof(syscallNames) / sizeof(char *)))
+        return "unknown";
+    return syscallNames[type];
+}
+
 
 // AdvancePC 用来增加 PC 寄存器，只有在系统调用的异常处理过程中被使用
 // 防止我们重启系统调用的异常程序，造成无限循环
@@ -39,6 +57,118 @@ void AdvancePC() {
     machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg) + 4);
 }
 
+//----------------------------------------------------------------------
+// CanTransfer
+// 	Whether the process may read (or, if "writing", write) through
+//	"entry", an entry in the open-file table: a file, the console or
+//	the right end of a pipe.
+//----------------------------------------------------------------------
+
+static bool
+CanTransfer(OpenFileEntry *entry, bool writing) {
+    return entry != NULL && (entry->pipe == NULL || entry->writeEnd == writing);
+}
+
+//----------------------------------------------------------------------
+// UserWrite
+// 	Write the "size" bytes at user address "base" to "entry" -- a file,
+//	stdout or a pipe -- a page at a time, straight out of the user's
+//	pages: each is pinned in memory while the file system (or the
+//	pipe) takes it, so a Write of any size copies nothing into the
+//	kernel first and allocates nothing.  Return how many bytes were
+//	written -- fewer than "size" if part of the buffer isn't a legal
+//	address, or the pipe's read end is closed.
+//----------------------------------------------------------------------
+
+static int
+UserWrite(OpenFileEntry *entry, int base, int size) {
+    AddrSpace *user = currentThread->space;
+    int done = 0;
+
+    while (done < size) {
+        int addr = base + done;
+        int count = min(size - done, PageSize - addr % PageSize);
+        char *page = user->PinUserPage(addr, FALSE);
+        int written;
+
+        if (page == NULL)
+            break;
+        if (entry->pipe != NULL)
+            written = entry->pipe->Write(page, count);
+#ifdef MYFILESYS
+        else if (entry->console)
+            written = entry->file->WriteStdout(page, count);
+#endif
+        else
+            written = entry->file->Write(page, count);
+        user->UnpinUserPage(page);
+        if (written <= 0)
+            break;
+        done += written;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// UserRead
+// 	Read up to "size" bytes from "entry" -- a file, stdin or a pipe --
+//	straight into the user's pages at "base", a page at a time, as
+//	UserWrite does.  Stop early at the end of the file, when the
+//	console has no more typed, or when the pipe has no more in it.
+//	Return how many bytes were read.
+//----------------------------------------------------------------------
+
+static int
+UserRead(OpenFileEntry *entry, int base, int size) {
+    AddrSpace *user = currentThread->space;
+    int done = 0;
+
+    while (done < size) {
+        int addr = base + done;
+        int count = min(size - done, PageSize - addr % PageSize);
+        char *page = user->PinUserPage(addr, TRUE);
+        int got;
+
+        if (page == NULL)
+            break;
+        if (entry->pipe != NULL)
+            got = entry->pipe->Read(page, count);
+#ifdef MYFILESYS
+        else if (entry->console)
+            got = entry->file->ReadStdin(page, count);
+#endif
+        else
+            got = entry->file->Read(page, count);
+        user->UnpinUserPage(page);
+        if (got > 0)
+            done += got;
+        if (got < count)
+            break;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// ReadUserWord
+// 	Read the word at user address "addr" into "value".  Unlike
+//	Machine::ReadMem, a bad address isn't raised as an exception --
+//	the caller is told, and can fail its system call.
+//----------------------------------------------------------------------
+
+static bool
+ReadUserWord(int addr, int *value) {
+    char *where;
+
+    if (addr % 4 != 0)          // so it's all on one page
+        return FALSE;
+    where = currentThread->space->PinUserPage(addr, FALSE);
+    if (where == NULL)
+        return FALSE;
+    *value = WordToHost(*(unsigned int *) where);
+    currentThread->space->UnpinUserPage(where);
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -84,7 +214,31 @@ ExceptionHandler(ExceptionType which) {
     OpenFile *executable;
     char *forkedThreadName;
     int ExitStatus;
+    if (which == PageFaultException) {
+#ifdef VM
+        // demand paging -- the faulting instruction is simply re-run
+        int badVAddr = machine->ReadRegister(BadVAddrReg);
+        if (currentThread->space->PageFault(badVAddr))
+            return;
+        printf("Bad virtual address 0x%x in process %d\n", badVAddr,
+               currentThread->space->getSpaceID());
+        ASSERT(FALSE);
+#else
+        stats->numPageFaults++;
+        currentThread->accounting.numPageFaults++;
+#endif
+    }
+#ifdef VM
+    if (which == ReadOnlyException) {
+        // a store to a copy-on-write page -- copy it and re-run
+        if (currentThread->space->CopyOnWrite(
+                machine->ReadRegister(BadVAddrReg)))
+            return;
+    }
+#endif
     if (which == SyscallException) {
+        TRACE('B', "syscall", SyscallName(type), TracePidSyscalls,
+              currentThread->getThreadId());
         switch (type) {
             case SC_Halt:
                 DEBUG('a', "Shutdown, initiated by user program. \n");
@@ -110,13 +264,235 @@ ExceptionHandler(ExceptionType which) {
                 }
                 printf("Execute system call of Exit(). \n");
                 AdvancePC();
+                TRACE('E', "syscall", "Exit", TracePidSyscalls,
+                      currentThread->getThreadId());
+#ifdef VM
+                currentThread->space->PrintPagingStats();
+                // the AddrSpace stays around for Join; its memory needn't
+                currentThread->space->ReleasePages();
+#endif
+                currentThread->space->CloseFiles();
                 currentThread->Finish();
                 delete currentThread->space;
                 break;
+            case SC_Fork:
+#ifdef VM
+                // both processes continue after the syscall
+                AdvancePC();
+                space = new AddrSpace(currentThread->space);
+                thread = new Thread("forked process");
+                thread->space = space;
+                thread->SaveUserState();    // the registers we have now
+                thread->Fork(ForkedProcess, space->getSpaceID());
+                machine->WriteRegister(2, space->getSpaceID());
+#else
+                printf("Fork needs virtual memory\n");
+                machine->WriteRegister(2, -1);
+                AdvancePC();
+#endif
+                break;
             case SC_Yield:
                 currentThread->Yield();
                 AdvancePC();
                 break;
+            case SC_Sleep:
+                // block on the kernel alarm instead of spinning in Yield
+                AdvancePC();
+                alarmClock->Pause(machine->ReadRegister(4));
+                break;
+            case SC_ProcStat: {
+                int id = machine->ReadRegister(4);
+                int buf = machine->ReadRegister(5);
+                ThreadStats st;
+
+                thread = (id == -1) ? currentThread : scheduler->FindUserThread(id);
+                if (thread == NULL) {
+                    machine->WriteRegister(2, -1);
+                } else {
+                    // same field order as ProcStats in syscall.h
+                    thread->GetStats(&st);
+                    machine->WriteMem(buf, 4, st.userTicks);
+                    machine->WriteMem(buf + 4, 4, st.systemTicks);
+                    machine->WriteMem(buf + 8, 4, st.readyTicks);
+                    machine->WriteMem(buf + 12, 4, st.blockedTicks);
+                    machine->WriteMem(buf + 16, 4, st.voluntarySwitches);
+                    machine->WriteMem(buf + 20, 4, st.involuntarySwitches);
+                    machine->WriteMem(buf + 24, 4, st.numPageFaults);
+                    machine->WriteRegister(2, 0);
+                }
+                AdvancePC();
+                break;
+            }
+            case SC_MemStat: {
+                int id = machine->ReadRegister(4);
+#ifdef VM
+                int buf = machine->ReadRegister(5);
+#endif
+
+                thread = (id == -1) ? currentThread : scheduler->FindUserThread(id);
+#ifdef VM
+                if (thread != NULL) {
+                    PagingStats ps;
+
+                    // same field order as MemStats in syscall.h
+                    thread->space->GetPagingStats(&ps);
+                    machine->WriteMem(buf, 4, ps.residentPages);
+                    machine->WriteMem(buf + 4, 4, ps.majorFaults);
+                    machine->WriteMem(buf + 8, 4, ps.minorFaults);
+                    machine->WriteMem(buf + 12, 4, ps.swapIns);
+                    machine->WriteMem(buf + 16, 4, ps.swapOuts);
+                    machine->WriteMem(buf + 20, 4, ps.workingSet);
+                    machine->WriteMem(buf + 24, 4, ps.frameLimit);
+                    machine->WriteRegister(2, 0);
+                } else
+#endif
+                    machine->WriteRegister(2, -1);
+                AdvancePC();
+                break;
+            }
+            case SC_Mmap: {
+                int start = -1;
+#ifdef VM
+                int fileId = machine->ReadRegister(4);
+                OpenFile *openfile = currentThread->space->getFileId(fileId);
+
+                if (openfile != NULL)   // a file, not a pipe or the console
+                    start = currentThread->space->Map(openfile,
+                                                      machine->ReadRegister(5),
+                                                      machine->ReadRegister(6));
+#endif
+                machine->WriteRegister(2, start);
+                AdvancePC();
+                break;
+            }
+            case SC_Munmap: {
+                bool unmapped = FALSE;
+#ifdef VM
+                unmapped = currentThread->space->Unmap(machine->ReadRegister(4),
+                                                       FALSE);
+#endif
+                machine->WriteRegister(2, unmapped ? 0 : -1);
+                AdvancePC();
+                break;
+            }
+            case SC_ShmCreate:
+            case SC_ShmAttach: {
+                int start = -1;
+#ifdef VM
+                start = currentThread->space->Attach(machine->ReadRegister(4),
+                                                     machine->ReadRegister(5),
+                                                     type == SC_ShmCreate);
+#endif
+                machine->WriteRegister(2, start);
+                AdvancePC();
+                break;
+            }
+            case SC_Sbrk: {
+                int old = -1;
+#ifdef VM
+                old = currentThread->space->Sbrk(machine->ReadRegister(4));
+#endif
+                machine->WriteRegister(2, old);
+                AdvancePC();
+                break;
+            }
+            case SC_FutexWait:
+                machine->WriteRegister(2, futexTable->Wait(machine->ReadRegister(4),
+                                                           machine->ReadRegister(5)));
+                AdvancePC();
+                break;
+            case SC_FutexWake:
+                machine->WriteRegister(2, futexTable->Wake(machine->ReadRegister(4),
+                                                           machine->ReadRegister(5)));
+                AdvancePC();
+                break;
+            case SC_ShmDetach: {
+                bool detached = FALSE;
+#ifdef VM
+                detached = currentThread->space->Unmap(machine->ReadRegister(4),
+                                                       TRUE);
+#endif
+                machine->WriteRegister(2, detached ? 0 : -1);
+                AdvancePC();
+                break;
+            }
+            case SC_ReadV:
+            case SC_WriteV: {
+                int iov = machine->ReadRegister(4);
+                int count = machine->ReadRegister(5);
+                int fileId = machine->ReadRegister(6);
+                bool writing = (type == SC_WriteV);
+                OpenFileEntry *entry = currentThread->space->getFileEntry(fileId);
+                int total = -1;
+
+                if (CanTransfer(entry, writing) && count >= 0 && count <= MaxIoVecs) {
+#ifdef MYFILESYS
+                    if (writing && entry->pipe == NULL && !entry->console)
+                        entry->file->Seek(entry->file->Length());   // append,
+                                                                    // as Write does
+#endif
+                    total = 0;
+                    for (i = 0; i < count; i++) {
+                        int base, len, done;
+
+                        // an IoVec is two words: base, then len
+                        if (!ReadUserWord(iov + 8 * i, &base) ||
+                            !ReadUserWord(iov + 8 * i + 4, &len)) {
+                            total = -1;
+                            break;
+                        }
+                        if (writing)
+                            done = UserWrite(entry, base, len);
+                        else
+                            done = UserRead(entry, base, len);
+                        total += done;
+                        if (done < len)     // the end of the file, of the
+                            break;          // console's input, or of a pipe
+                    }
+                }
+                machine->WriteRegister(2, total);
+                AdvancePC();
+                break;
+            }
+            case SC_Pipe: {
+                int fdArray = machine->ReadRegister(4);
+                OpenFileEntry *readEnd, *writeEnd;
+                int readFd, writeFd = -1;
+
+                fileTable->OpenPipe(&readEnd, &writeEnd);
+                readFd = currentThread->space->getFileDescriptor(readEnd);
+                if (readFd >= 0)
+                    writeFd = currentThread->space->getFileDescriptor(writeEnd);
+                if (writeFd < 0) {      // too many files open
+                    if (readFd >= 0)
+                        currentThread->space->releaseFileDescriptor(readFd);
+                    else
+                        fileTable->Release(readEnd);
+                    fileTable->Release(writeEnd);
+                    machine->WriteRegister(2, -1);
+                } else {
+                    machine->WriteMem(fdArray, 4, readFd);
+                    machine->WriteMem(fdArray + 4, 4, writeFd);
+                    machine->WriteRegister(2, 0);
+                }
+                AdvancePC();
+                break;
+            }
+            case SC_Dup: {
+                OpenFileEntry *entry =
+                        currentThread->space->getFileEntry(machine->ReadRegister(4));
+                int fd = -1;
+
+                if (entry != NULL) {
+                    fileTable->Hold(entry);
+                    fd = currentThread->space->getFileDescriptor(entry);
+                    if (fd < 0)
+                        fileTable->Release(entry);
+                }
+                machine->WriteRegister(2, fd);
+                AdvancePC();
+                break;
+            }
 #ifdef FILESYS_STUB
                 case SC_Exec:
                 // lab78: 增加实现
@@ -132,13 +508,15 @@ ExceptionHandler(ExceptionType which) {
                 executable = fileSystem->Open(filename);
                 if (executable == NULL) {
                     printf("Unable to open file %s\n", filename);
-                    return;
+                    machine->WriteRegister(2, -1);
+                    AdvancePC();
+                    break;
                 }
 
                 // lab78: 创建一个用户空间
                 //  这个space要怎么把他传给？
-                space = new AddrSpace(executable);
-                delete executable;
+                space = new AddrSpace(executable);   // now owns executable
+                space->InheritStdio(currentThread->space);
 
                 forkedThreadName = filename;
 
@@ -185,14 +563,20 @@ ExceptionHandler(ExceptionType which) {
                     int base = machine->ReadRegister(4);
                     int value;
                     int count = 0;
-                    char *FileName = new char[128];
+                    char FileName[128];
                     do {
                         machine->ReadMem(base + count, 1, &value);
                         FileName[count] = *(char *) &value;
                         count++;
                     } while (*(char *) &value != '\0' && count < 128);
 
-                    int fileDescriptor = OpenForReadWrite(FileName, FALSE);
+                    int fileDescriptor = -1;
+                    OpenFileEntry *entry = fileTable->Open(FileName);
+                    if (entry != NULL) {
+                        fileDescriptor = currentThread->space->getFileDescriptor(entry);
+                        if (fileDescriptor < 0)
+                            fileTable->Release(entry);
+                    }
                     if (fileDescriptor == -1)
                         printf("Open file %s failed!\n", FileName);
                     else
@@ -205,67 +589,35 @@ ExceptionHandler(ExceptionType which) {
                     int base = machine->ReadRegister(4);
                     int size = machine->ReadRegister(5);
                     int fileId = machine->ReadRegister(6);
-                    int value;
-                    int count = 0;
-
-                    printf("base=%d, size=%d, fileId=%d \n", base, size, fileId);
-                    OpenFile *openfile = new OpenFile(fileId);
-                    ASSERT(openfile != NULL);
-
-                    char *buffer = new char[128];
-                    do {
-                        machine->ReadMem(base + count, 1, &value);
-                        buffer[count] = *(char *) &value;
-                        count++;
-                    } while ((*(char *) &value != '\0') && (count < size));
-                    buffer[size] = '\0';
+                    OpenFileEntry *entry = currentThread->space->getFileEntry(fileId);
+                    int writtenBytes = -1;
 
-                    int WritePosition;
-                    if (fileId == 1)
-                        WritePosition = 0;
-                    else
-                        WritePosition = openfile->Length();
-
-                    int writtenBytes = openfile->WriteAt(buffer, size, WritePosition);
-                    if ((writtenBytes) == 0)
+                    if (CanTransfer(entry, TRUE))
+                        writtenBytes = UserWrite(entry, base, size);
+                    if (writtenBytes <= 0)
                         printf("write file failed!\n");
-                    else
-                        printf("\"%s\" has wrote in file %d succeed!\n", buffer, fileId);
-                    // lab78: 为什么之前没有将这个内容放到
-                    machine->WriteRegister(2, size);
+                    machine->WriteRegister(2, writtenBytes);
                     AdvancePC();
-
                     break;
                 }
                 case SC_Read: {
                     int base = machine->ReadRegister(4);
                     int size = machine->ReadRegister(5);
                     int fileId = machine->ReadRegister(6);
+                    OpenFileEntry *entry = currentThread->space->getFileEntry(fileId);
+                    int readnum = -1;
 
-                    OpenFile *openfile = new OpenFile(fileId);
-                    char buffer[size];
-                    int readnum = 0;
-                    readnum = openfile->Read(buffer, size);
-
-                    for (int i = 0; i < size; i++)
-                        if (!machine->WriteMem(base, 1, buffer[i]))
-                            printf("This is something wrong.\n");
-                    buffer[size] = '\0';
-                    printf("read succeed! the content is \"%s\" , the length is %d\n", buffer, size);
+                    if (CanTransfer(entry, FALSE))
+                        readnum = UserRead(entry, base, size);
                     machine->WriteRegister(2, readnum);
                     AdvancePC();
                     break;
                 }
                 case SC_Close: {
                     int fileId = machine->ReadRegister(4);
-                    //printf("SC_Close: fileId in $4 = %d\n",fileId);
-                    //void Close(int fd) in sysdep.cc
 
-                    //OpenFile* openfile=new OpenFile(fileId);
-                    //delete openfile;  //does not work well
-                    Close(fileId);
-
-                    printf("File %d  closed succeed!\n", fileId);
+                    if (currentThread->space->releaseFileDescriptor(fileId))
+                        printf("File %d  closed succeed!\n", fileId);
                     AdvancePC();
                     break;
                 }
@@ -646,8 +998,8 @@ ExceptionHandler(ExceptionType which) {
                 }
 
                 //new address space
-                space = new AddrSpace(executable);
-                delete executable;            // close file
+                space = new AddrSpace(executable);    // now owns executable
+                space->InheritStdio(currentThread->space);  // maybe a pipe
 
                 DEBUG('H', "Execute system call Exec(\"%s\"), it's SpaceId(pid) = %d \n", filename,
                       space->getSpaceID());
@@ -715,7 +1067,7 @@ ExceptionHandler(ExceptionType which) {
                 int base = machine->ReadRegister(4);
                 int value;
                 int count = 0;
-                char *FileName = new char[128];
+                char FileName[128];
 
                 do {
                     machine->ReadMem(base + count, 1, &value);
@@ -724,17 +1076,19 @@ ExceptionHandler(ExceptionType which) {
                 } while (*(char *) &value != '\0' && count < 128);
 
                 int fileid;
-                //call Open() in FILESYS,see filesys.h,Nachos Open()
-                OpenFile *openfile = fileSystem->Open(FileName);
-                if (openfile == NULL) {   //file not existes, not found
+                // an entry in the system-wide open-file table, which
+                // shares the header if the file is open already
+                OpenFileEntry *entry = fileTable->Open(FileName);
+                if (entry == NULL) {   //file not existes, not found
                     printf("File \"%s\" not Exists, could not open it.\n", FileName);
                     fileid = -1;
                 } else {  //file found
 //set the opened file id in AddrSpace, which wiil be used in Read() and Write()
-                    fileid = currentThread->space->getFileDescriptor(openfile);
-                    if (fileid < 0)
+                    fileid = currentThread->space->getFileDescriptor(entry);
+                    if (fileid < 0) {
                         printf("Too many files opened!\n");
-                    else
+                        fileTable->Release(entry);
+                    } else
                         DEBUG('f', "file :%s open secceed!  the file id is %d\n", FileName, fileid);
                 }
                 machine->WriteRegister(2, fileid);
@@ -746,58 +1100,25 @@ ExceptionHandler(ExceptionType which) {
                 int base = machine->ReadRegister(4);  //buffer
                 int size = machine->ReadRegister(5);   //bytes written to file
                 int fileId = machine->ReadRegister(6); //fd
-                int value;
-                int count = 0;
-
-                // printf("base=%d, size=%d, fileId=%d \n",base,size,fileId );
-                OpenFile *openfile = new OpenFile(fileId);
-                ASSERT(openfile != NULL);
-
-                char *buffer = new char[128];
-                do {
-                    machine->ReadMem(base + count, 1, &value);
-                    buffer[count] = *(char *) &value;
-                    count++;
-                } while ((*(char *) &value != '\0') && (count < size));
-                buffer[size] = '\0';
+                OpenFileEntry *entry = currentThread->space->getFileEntry(fileId);
 
-//                OpenFile *openfile = currentThread->space->getFileId(fileId);
-                openfile = currentThread->space->getFileId(fileId);
-                //printf("openfile =%d\n",openfile);
-                if (openfile == NULL) {
+                if (!CanTransfer(entry, TRUE)) {
                     printf("Failed to Open file \"%d\" .\n", fileId);
+                    machine->WriteRegister(2, -1);
                     AdvancePC();
                     break;
                 }
 
-                if (fileId == 1 || fileId == 2) {
-                    openfile->WriteStdout(buffer, size);
-                    delete[] buffer;
-                    AdvancePC();
-                    break;
-                }
-
-                int WritePosition = openfile->Length();
+                bool isFile = (entry->pipe == NULL && !entry->console);
+                if (isFile)
+                    entry->file->Seek(entry->file->Length());  //append write
 
-                openfile->Seek(WritePosition);  //append write
-                //openfile->Seek(0);      //write form  begining
-
-                int writtenBytes;
-                //writtenBytes = openfile->AppendWriteAt(buffer,size,WritePosition);
-                writtenBytes = openfile->Write(buffer, size);
-                if ((writtenBytes) == 0)
+                int writtenBytes = UserWrite(entry, base, size);
+                if (writtenBytes == 0)
                     DEBUG('f', "\nWrite file failed!\n");
-                else {
-                    if (fileId != 1 && fileId != 2) {
-                        DEBUG('f', "\n\"%s\" has wrote in file %d succeed!\n", buffer, fileId);
-                        DEBUG('H', "\n\"%s\" has wrote in file %d succeed!\n", buffer, fileId);
-                        DEBUG('J', "\n\"%s\" has wrote in file %d succeed!\n", buffer, fileId);
-                    }
-                    //printf("\n\"%s\" has wrote in file %d succeed!\n",buffer,fileId);
-                }
-
-                //delete openfile;
-                delete[] buffer;
+                else if (isFile)
+                    DEBUG('f', "\n%d bytes written to file %d\n", writtenBytes, fileId);
+                machine->WriteRegister(2, writtenBytes);
                 AdvancePC();
                 break;
             }
@@ -807,35 +1128,16 @@ ExceptionHandler(ExceptionType which) {
                 int base = machine->ReadRegister(4);
                 int size = machine->ReadRegister(5);
                 int fileId = machine->ReadRegister(6);
-
-                OpenFile *openfile = currentThread->space->getFileId(fileId);
-
-                char buffer[size];
-                int readnum = 0;
-                if (fileId == 0)  //stdin
-                    readnum = openfile->ReadStdin(buffer, size);
-                else
-                    readnum = openfile->Read(buffer, size);
-
-                for (int i = 0; i < readnum; i++)
-                    machine->WriteMem(base, 1, buffer[i]);
-                buffer[readnum] = '\0';
-
-                for (int i = 0; i < readnum; i++)
-                    if (buffer[i] >= 0 && buffer[i] <= 9)
-                        buffer[i] = buffer[i] + 0x30;
-
-                char *buf = buffer;
-                if (readnum > 0) {
-                    if (fileId != 0) {
-                        DEBUG('f', "Read file (%d) succeed! the content is \"%s\" , the length is %d\n", fileId, buf,
-                              readnum);
-                        DEBUG('H', "Read file (%d) succeed! the content is \"%s\" , the length is %d\n", fileId, buf,
-                              readnum);
-                        DEBUG('J', "Read file (%d) succeed! the content is \"%s\" , the length is %d\n", fileId, buf,
-                              readnum);
-                    }
-                } else
+                OpenFileEntry *entry = currentThread->space->getFileEntry(fileId);
+                int readnum = -1;
+
+                if (CanTransfer(entry, FALSE)) {
+                    readnum = UserRead(entry, base, size);
+                    if (readnum > 0 && entry->pipe == NULL && !entry->console)
+                        DEBUG('f', "Read file (%d) succeed! the length is %d\n",
+                              fileId, readnum);
+                }
+                if (readnum < 0)        // 0 is just the end of the file
                     printf("\nRead file failed!\n");
 
                 machine->WriteRegister(2, readnum);
@@ -845,13 +1147,9 @@ ExceptionHandler(ExceptionType which) {
 
             case SC_Close: {
                 int fileId = machine->ReadRegister(4);
-                OpenFile *openfile = currentThread->space->getFileId(fileId);
-                if (openfile != NULL) {
-                    openfile->WriteBack();  // write file header back to DISK
-
-                    delete openfile;        // close file
-                    currentThread->space->releaseFileDescriptor(fileId);
-
+                // the header goes back to disk when the last descriptor
+                // on the file, in any process, is closed
+                if (currentThread->space->releaseFileDescriptor(fileId)) {
                     DEBUG('f', "File %d  closed succeed!\n", fileId);
                     DEBUG('H', "File %d  closed succeed!\n", fileId);
                     DEBUG('J', "File %d  closed succeed!\n", fileId);
@@ -866,6 +1164,9 @@ ExceptionHandler(ExceptionType which) {
                 printf("Unexpected syscall %d %d\n", which, type);
                 ASSERT(FALSE);
         }
+        // still the calling thread, even if it blocked along the way
+        TRACE('E', "syscall", SyscallName(type), TracePidSyscalls,
+              currentThread->getThreadId());
     } else {
         printf("Unexpected user mode exception %d %d\n", which, type);
         ASSERT(FALSE);
@@ -0,0 +1,441 @@
+// filetable.cc
+//	Routines to manage the system-wide open-file table and each
+//	process's file descriptors.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "filetable.h"
+#include "system.h"
+#include "synch.h"
+#include "bitmap.h"
+#include "pipe.h"
+#ifdef MYFILESYS
+#include "filehdr.h"
+#endif
+
+#ifdef MYFILESYS
+// The in-memory header of a file that is open, shared by every
+// OpenFile on it.
+
+class CachedHeader {
+public:
+    int sector;                 // where the header lives on disk
+    FileHeader *hdr;
+    int refCount;               // how many OpenFiles use it
+};
+#endif
+
+//----------------------------------------------------------------------
+// MakeEntry
+// 	Return a table entry for "file", named by one descriptor.
+//----------------------------------------------------------------------
+
+static OpenFileEntry *
+MakeEntry(OpenFile *file, bool console) {
+    OpenFileEntry *entry = new OpenFileEntry;
+
+    entry->file = file;
+    entry->refCount = 1;
+    entry->console = console;
+    entry->pipe = NULL;
+    entry->writeEnd = FALSE;
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize the open-file table with only the console in it.
+//----------------------------------------------------------------------
+
+FileTable::FileTable() {
+    lock = new Lock("file table lock");
+#ifdef FILESYS_STUB
+    stdinEntry = MakeEntry(new OpenFile(0), TRUE);
+    stdoutEntry = MakeEntry(new OpenFile(1), TRUE);
+#else
+    stdinEntry = MakeEntry(new OpenFile("stdin"), TRUE);
+    stdoutEntry = MakeEntry(new OpenFile("stdout"), TRUE);
+#endif
+    numOpens = numShared = 0;
+#ifdef MYFILESYS
+    headers = new List;
+#endif
+}
+
+FileTable::~FileTable() {
+    delete lock;
+#ifdef MYFILESYS
+    delete headers;
+#endif
+}
+
+//----------------------------------------------------------------------
+// FileTable::Open
+// 	Open the file called "name" and return a new entry for it, named
+//	by one descriptor.  Return NULL if there is no such file.
+//
+//	With our own file system, the header of a file that is already
+//	open is shared instead of being read again.
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+FileTable::Open(char *name) {
+    OpenFile *file;
+
+    lock->Acquire();
+#ifdef MYFILESYS
+    int sector = fileSystem->Lookup(name);
+
+    file = NULL;
+    if (sector >= 0)
+        file = new OpenFile(sector, HoldHeader(sector));
+#else
+    file = fileSystem->Open(name);
+#endif
+    if (file != NULL)
+        numOpens++;
+    lock->Release();
+    if (file == NULL)
+        return NULL;
+    return MakeEntry(file, FALSE);
+}
+
+//----------------------------------------------------------------------
+// FileTable::OpenPipe
+// 	Make a new, empty pipe, and an entry for each of its ends, each
+//	named by one descriptor.
+//----------------------------------------------------------------------
+
+void
+FileTable::OpenPipe(OpenFileEntry **readEnd, OpenFileEntry **writeEnd) {
+    PipeBuffer *pipe = new PipeBuffer;
+
+    *readEnd = MakeEntry(NULL, FALSE);
+    (*readEnd)->pipe = pipe;
+    *writeEnd = MakeEntry(NULL, FALSE);
+    (*writeEnd)->pipe = pipe;
+    (*writeEnd)->writeEnd = TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Hold
+// 	Note that one more descriptor names "entry".
+//----------------------------------------------------------------------
+
+void
+FileTable::Hold(OpenFileEntry *entry) {
+    lock->Acquire();
+    entry->refCount++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// FileTable::Release
+// 	Note that one fewer descriptor names "entry".  When none do,
+//	write the file's header back to disk and close the file -- or,
+//	for a pipe, close that end, and the pipe once both ends are.
+//----------------------------------------------------------------------
+
+void
+FileTable::Release(OpenFileEntry *entry) {
+    lock->Acquire();
+    ASSERT(entry->refCount > 0);
+    if (--entry->refCount == 0 && entry->pipe != NULL) {
+        entry->pipe->CloseEnd(entry->writeEnd);
+        if (entry->pipe->Closed())
+            delete entry->pipe;
+        delete entry;
+    } else if (entry->refCount == 0 && !entry->console) {
+#ifdef MYFILESYS
+        int sector = entry->file->HeaderSector();
+
+        entry->file->WriteBack();
+        delete entry->file;
+        ReleaseHeader(sector);
+#else
+        delete entry->file;
+#endif
+        delete entry;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// FileTable::Print
+// 	Print how many opens found their file's header already in memory.
+//----------------------------------------------------------------------
+
+void
+FileTable::Print() {
+    printf("Open files: %d opens, %d with a shared header\n",
+           numOpens, numShared);
+}
+
+#ifdef MYFILESYS
+//----------------------------------------------------------------------
+// FileTable::HoldHeader
+// 	Return the in-memory header stored at "sector", reading it from
+//	disk only if no open file already has it.  Called with the lock
+//	held.
+//----------------------------------------------------------------------
+
+FileHeader *
+FileTable::HoldHeader(int sector) {
+    CachedHeader *cached;
+
+    for (ListElement *e = headers->getFirst(); e != NULL; e = e->next) {
+        cached = (CachedHeader *) e->item;
+        if (cached->sector == sector) {
+            cached->refCount++;
+            numShared++;
+            return cached->hdr;
+        }
+    }
+    cached = new CachedHeader;
+    cached->sector = sector;
+    cached->hdr = new FileHeader;
+    cached->hdr->FetchFrom(sector);
+    cached->refCount = 1;
+    headers->Append((void *) cached);
+    return cached->hdr;
+}
+
+//----------------------------------------------------------------------
+// FileTable::ReleaseHeader
+// 	One fewer OpenFile uses the header stored at "sector"; drop it
+//	when none do.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+FileTable::ReleaseHeader(int sector) {
+    int i = 1;
+
+    for (ListElement *e = headers->getFirst(); e != NULL; e = e->next, i++) {
+        CachedHeader *cached = (CachedHeader *) e->item;
+
+        if (cached->sector == sector) {
+            if (--cached->refCount == 0) {
+                headers->RemoveItem(i);
+                delete cached->hdr;
+                delete cached;
+            }
+            return;
+        }
+    }
+    ASSERT(FALSE);
+}
+#endif // MYFILESYS
+
+//----------------------------------------------------------------------
+// LowestBit
+// 	Return the number of the lowest bit set in "word", which mustn't
+//	be zero.
+//----------------------------------------------------------------------
+
+static int
+LowestBit(unsigned int word) {
+    ASSERT(word != 0);
+    return __builtin_ctz(word);
+}
+
+//----------------------------------------------------------------------
+// FdTable::FdTable
+// 	Initialize a process's file descriptors, with 0 naming stdin and
+//	1 and 2 naming stdout.
+//----------------------------------------------------------------------
+
+FdTable::FdTable() {
+    size = FdTableSize;
+    entries = new OpenFileEntry *[size];
+    freeBits = new unsigned int[size / BitsInWord];
+    for (int i = 0; i < size; i++)
+        entries[i] = NULL;
+    freeBits[0] = ~0u;
+    summary = 1;
+    lock = new RWLock("fd table lock");
+
+    fileTable->Hold(fileTable->Stdin());
+    fileTable->Hold(fileTable->Stdout());
+    fileTable->Hold(fileTable->Stdout());
+    Add(fileTable->Stdin());
+    Add(fileTable->Stdout());
+    Add(fileTable->Stdout());
+}
+
+//----------------------------------------------------------------------
+// FdTable::FdTable
+// 	Initialize a forked child's file descriptors: the same numbers,
+//	naming the same entries -- so the two processes share offsets --
+//	as the parent's.
+//----------------------------------------------------------------------
+
+FdTable::FdTable(FdTable *parent) {
+    parent->lock->ReadAcquire();
+    size = parent->size;
+    entries = new OpenFileEntry *[size];
+    freeBits = new unsigned int[size / BitsInWord];
+    for (int i = 0; i < size; i++) {
+        entries[i] = parent->entries[i];
+        if (entries[i] != NULL)
+            fileTable->Hold(entries[i]);
+    }
+    for (int w = 0; w < size / BitsInWord; w++)
+        freeBits[w] = parent->freeBits[w];
+    summary = parent->summary;
+    parent->lock->ReadRelease();
+    lock = new RWLock("fd table lock");
+}
+
+FdTable::~FdTable() {
+    CloseAll();
+    delete[] entries;
+    delete[] freeBits;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// FdTable::Add
+// 	Make the lowest free descriptor name "entry", growing the table
+//	if every descriptor is in use.  Return the descriptor, or -1 if
+//	the table is as big as it gets.
+//----------------------------------------------------------------------
+
+int
+FdTable::Add(OpenFileEntry *entry) {
+    int word, fd;
+
+    lock->WriteAcquire();
+    if (summary == 0) {
+        if (size == MaxFileDescriptors) {
+            lock->WriteRelease();
+            return -1;
+        }
+        Grow();
+    }
+    word = LowestBit(summary);
+    fd = word * BitsInWord + LowestBit(freeBits[word]);
+    freeBits[word] &= ~(1u << (fd % BitsInWord));
+    if (freeBits[word] == 0)
+        summary &= ~(1u << word);
+    entries[fd] = entry;
+    lock->WriteRelease();
+    return fd;
+}
+
+//----------------------------------------------------------------------
+// FdTable::Get
+// 	Return the entry "fd" names, or NULL if it isn't open.
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+FdTable::Get(int fd) {
+    OpenFileEntry *entry;
+
+    if (fd < 0)
+        return NULL;
+    lock->ReadAcquire();
+    entry = (fd < size) ? entries[fd] : NULL;
+    lock->ReadRelease();
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// FdTable::Remove
+// 	Free descriptor "fd", and return the entry it named -- which the
+//	caller should Release -- or NULL if it wasn't open.
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+FdTable::Remove(int fd) {
+    OpenFileEntry *entry = NULL;
+
+    if (fd < 0)
+        return NULL;
+    lock->WriteAcquire();
+    if (fd < size && entries[fd] != NULL) {
+        entry = entries[fd];
+        entries[fd] = NULL;
+        freeBits[fd / BitsInWord] |= 1u << (fd % BitsInWord);
+        summary |= 1u << (fd / BitsInWord);
+    }
+    lock->WriteRelease();
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// FdTable::Inherit
+// 	Make descriptors 0 .. count-1 name what they do in "parent" -- as
+//	Exec does for stdin, stdout and stderr, so that a shell can run a
+//	program with them redirected, into a pipe say.
+//----------------------------------------------------------------------
+
+void
+FdTable::Inherit(FdTable *parent, int count) {
+    ASSERT(count <= FdTableSize);
+    for (int fd = 0; fd < count; fd++) {
+        OpenFileEntry *theirs = parent->Get(fd);
+        OpenFileEntry *mine = Remove(fd);
+
+        if (theirs != NULL) {
+            fileTable->Hold(theirs);
+            lock->WriteAcquire();
+            entries[fd] = theirs;
+            freeBits[0] &= ~(1u << fd);
+            if (freeBits[0] == 0)
+                summary &= ~1u;
+            lock->WriteRelease();
+        }
+        if (mine != NULL)
+            fileTable->Release(mine);
+    }
+}
+
+//----------------------------------------------------------------------
+// FdTable::CloseAll
+// 	Close every descriptor that is still open, as when the process
+//	exits.
+//----------------------------------------------------------------------
+
+void
+FdTable::CloseAll() {
+    for (int fd = 0; fd < size; fd++) {
+        OpenFileEntry *entry = Remove(fd);
+
+        if (entry != NULL)
+            fileTable->Release(entry);
+    }
+}
+
+//----------------------------------------------------------------------
+// FdTable::Grow
+// 	Double the number of descriptors; the new ones are all free.
+//	Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+FdTable::Grow() {
+    int newSize = size * 2;
+    OpenFileEntry **newEntries = new OpenFileEntry *[newSize];
+    unsigned int *newFree = new unsigned int[newSize / BitsInWord];
+
+    ASSERT(newSize <= MaxFileDescriptors);
+    for (int i = 0; i < newSize; i++)
+        newEntries[i] = (i < size) ? entries[i] : NULL;
+    for (int w = 0; w < newSize / BitsInWord; w++) {
+        if (w < size / BitsInWord)
+            newFree[w] = freeBits[w];
+        else {
+            newFree[w] = ~0u;
+            summary |= 1u << w;
+        }
+    }
+    delete[] entries;
+    delete[] freeBits;
+    entries = newEntries;
+    freeBits = newFree;
+    size = newSize;
+    DEBUG('f', "File descriptor table grown to %d\n", size);
+}
@@ -0,0 +1,117 @@
+// filetable.h
+//	Data structures for the files user programs have open.
+//
+//	As in UNIX there are two levels.  Each process has a table of
+//	file descriptors (FdTable), small integers naming entries in the
+//	system-wide open-file table (FileTable).  An entry holds the
+//	OpenFile, and so the seek offset, shared by every descriptor
+//	that names it -- all the descriptors a forked child inherits,
+//	for instance.  Entries for the same file share one in-memory
+//	file header, so a file that grows through one is seen to grow
+//	through all of them, and opening a file that is already open
+//	doesn't read its header from disk again.
+//
+//	An entry may instead be one end of a pipe (see pipe.h).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+#include "openfile.h"
+#include "list.h"
+
+class Lock;
+class RWLock;
+class FileHeader;
+class PipeBuffer;
+
+// One open file, named by any number of file descriptors.
+
+class OpenFileEntry {
+public:
+    OpenFile *file;             // the file, and where the next Read
+    // or Write through any of its
+    // descriptors starts
+    int refCount;               // how many descriptors name it
+    bool console;               // stdin or stdout: never closed
+    PipeBuffer *pipe;           // if not NULL, "file" is NULL and
+    bool writeEnd;              // this is one end of "pipe"
+};
+
+// The system-wide open-file table.
+
+class FileTable {
+public:
+    FileTable();                // just the console open
+    ~FileTable();
+
+    OpenFileEntry *Open(char *name);    // a new entry for the named
+    // file; NULL if there is no such file
+    void OpenPipe(OpenFileEntry **readEnd, OpenFileEntry **writeEnd);
+    // a new pipe, and entries for its ends
+    void Hold(OpenFileEntry *entry);    // one more descriptor names it
+    void Release(OpenFileEntry *entry); // one fewer; close the file
+    // when none do
+
+    OpenFileEntry *Stdin() { return stdinEntry; }
+    OpenFileEntry *Stdout() { return stdoutEntry; }
+
+    void Print();               // how often headers were shared
+
+private:
+    Lock *lock;                 // Open and Release may wait for the disk
+    OpenFileEntry *stdinEntry;  // shared by every process
+    OpenFileEntry *stdoutEntry;
+    int numOpens;               // entries made by Open
+    int numShared;              // ... that found their header in memory
+#ifdef MYFILESYS
+    List *headers;              // CachedHeader: the headers of the
+    // files that are open
+
+    FileHeader *HoldHeader(int sector);     // cached, or fetched
+    void ReleaseHeader(int sector);
+#endif
+};
+
+// A process's file descriptors.  0 is stdin, and 1 and 2 are stdout.
+//
+// The table starts with FdTableSize descriptors and doubles when they
+// are all in use, up to MaxFileDescriptors.  Add always hands out the
+// lowest free descriptor, as UNIX does, in constant time: one bit per
+// descriptor marks the free ones, and one summary bit per word of
+// those marks the words with a free descriptor in them.
+
+#define FdTableSize 32          // one word of free bits
+#define MaxFileDescriptors (32 * 32)    // one word of summary bits
+
+class FdTable {
+public:
+    FdTable();                  // just the console open
+    FdTable(FdTable *parent);   // the same entries as "parent", for Fork
+    ~FdTable();                 // closes whatever is still open
+
+    int Add(OpenFileEntry *entry);  // the lowest free descriptor now
+    // names "entry"; -1 if there is none
+    OpenFileEntry *Get(int fd);     // NULL if "fd" isn't open
+    OpenFileEntry *Remove(int fd);  // free "fd"; return what it named,
+    // or NULL if it wasn't open
+    void Inherit(FdTable *parent, int count);   // descriptors 0 ..
+    // count-1 name what they do in "parent"
+    void CloseAll();            // Remove and Release every descriptor
+
+private:
+    OpenFileEntry **entries;    // per descriptor: what it names
+    int size;                   // how many descriptors there are now
+    unsigned int *freeBits;     // per descriptor: 1 if it is free
+    unsigned int summary;       // per word of freeBits: 1 if any free
+    RWLock *lock;               // Get is a shared lookup; Add and
+    // Remove are exclusive
+
+    void Grow();                // double the table
+};
+
+#endif // FILETABLE_H
@@ -0,0 +1,289 @@
+// framealloc.cc
+//	Routines to allocate and free physical page frames.
+//
+//	Free lists hold frame numbers relative to the zone's base, so
+//	that a block's buddy is found by flipping one bit.  A frame on a
+//	zone's hot stack is not on any free list, and so never coalesces
+//	with its buddy until the stack is drained.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "framealloc.h"
+#include "utility.h"
+
+//----------------------------------------------------------------------
+// FrameAllocator::FrameAllocator
+// 	Initialize an allocator for frames 0 .. nFrames-1, split into
+//	"nZones" zones of (nearly) equal size, with every frame free.
+//----------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(int nFrames, int nZones) {
+    ASSERT(nZones >= 1 && nZones <= nFrames);
+    numZones = nZones;
+    zoneSize = nFrames / nZones;
+    zones = new FrameZone[nZones];
+
+    for (int n = 0; n < nZones; n++) {
+        FrameZone *z = &zones[n];
+
+        z->base = n * zoneSize;
+        z->size = (n == nZones - 1) ? nFrames - z->base : zoneSize;
+        for (z->maxOrder = 0; z->maxOrder < MaxFrameOrder &&
+             (2 << z->maxOrder) <= z->size; z->maxOrder++)
+            ;
+        for (int o = 0; o <= MaxFrameOrder; o++)
+            z->freeHead[o] = -1;
+        z->next = new int[z->size];
+        z->prev = new int[z->size];
+        z->order = new int[z->size];
+        for (int i = 0; i < z->size; i++)
+            z->order[i] = -1;
+        z->hot = new int[2 * HotBatch];
+        z->numHot = 0;
+
+        // carve the zone into the largest aligned blocks that fit
+        for (int i = 0; i < z->size;) {
+            int o = z->maxOrder;
+            while (o > 0 && ((i & ((1 << o) - 1)) || i + (1 << o) > z->size))
+                o--;
+            Push(z, i, o);
+            i += 1 << o;
+        }
+
+        z->numFree = z->size;
+        z->lowWater = max(1, z->size / 16);
+        z->highWater = 2 * z->lowWater;
+        z->numAllocs = z->numForeign = 0;
+    }
+}
+
+FrameAllocator::~FrameAllocator() {
+    for (int n = 0; n < numZones; n++) {
+        delete[] zones[n].next;
+        delete[] zones[n].prev;
+        delete[] zones[n].order;
+        delete[] zones[n].hot;
+    }
+    delete[] zones;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Push, FrameAllocator::Unlink
+// 	Put the free block headed by zone-relative frame "frame" on the
+//	free list for "order", or take it off its list.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Push(FrameZone *z, int frame, int order) {
+    z->order[frame] = order;
+    z->prev[frame] = -1;
+    z->next[frame] = z->freeHead[order];
+    if (z->freeHead[order] != -1)
+        z->prev[z->freeHead[order]] = frame;
+    z->freeHead[order] = frame;
+}
+
+void
+FrameAllocator::Unlink(FrameZone *z, int frame) {
+    int order = z->order[frame];
+
+    if (z->prev[frame] != -1)
+        z->next[z->prev[frame]] = z->next[frame];
+    else
+        z->freeHead[order] = z->next[frame];
+    if (z->next[frame] != -1)
+        z->prev[z->next[frame]] = z->prev[frame];
+    z->order[frame] = -1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::TakeBlock
+// 	Remove a free block of 2^order frames from zone "z", splitting a
+//	larger one if need be, and return its zone-relative first frame;
+//	-1 if there is none.  The halves split off go back on the lists.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::TakeBlock(FrameZone *z, int order) {
+    int o, block;
+
+    for (o = order; o <= z->maxOrder && z->freeHead[o] == -1; o++)
+        ;
+    if (o > z->maxOrder)
+        return -1;
+    block = z->freeHead[o];
+    Unlink(z, block);
+    while (o > order) {
+        o--;
+        Push(z, block + (1 << o), o);
+    }
+    return block;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::GiveBlock
+// 	Return the block of 2^order frames at zone-relative "frame" to
+//	zone "z", merging it with its buddy for as long as the buddy is
+//	free and whole.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::GiveBlock(FrameZone *z, int frame, int order) {
+    while (order < z->maxOrder) {
+        int buddy = frame ^ (1 << order);
+
+        if (buddy + (1 << order) > z->size || z->order[buddy] != order)
+            break;
+        Unlink(z, buddy);
+        frame = min(frame, buddy);
+        order++;
+    }
+    Push(z, frame, order);
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Return a free frame, from zone "zone" if it has one and otherwise
+//	from the next zone that does; -1 if every frame is in use.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::Allocate(int zone) {
+    for (int n = 0; n < numZones; n++) {
+        FrameZone *z = &zones[(zone + n) % numZones];
+
+        if (z->numHot == 0) {   // refill the stack
+            int frame;
+            while (z->numHot < HotBatch && (frame = TakeBlock(z, 0)) != -1)
+                z->hot[z->numHot++] = frame;
+        }
+        if (z->numHot > 0) {
+            z->numFree--;
+            z->numAllocs++;
+            if (n > 0)
+                z->numForeign++;
+            return z->base + z->hot[--z->numHot];
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Free
+// 	Return a frame got from Allocate.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Free(int frame) {
+    FrameZone *z = &zones[ZoneOf(frame)];
+
+    if (z->numHot == 2 * HotBatch) {    // drain half the stack
+        for (int i = 0; i < HotBatch; i++)
+            GiveBlock(z, z->hot[--z->numHot], 0);
+    }
+    z->hot[z->numHot++] = frame - z->base;
+    z->numFree++;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::AllocateRun
+// 	Return the first of 2^order contiguous free frames, aligned to
+//	their size within the zone, preferring zone "zone"; -1 if no zone
+//	has such a run.  A run never crosses zones.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::AllocateRun(int order, int zone) {
+    if (order == 0)
+        return Allocate(zone);
+
+    for (int n = 0; n < numZones; n++) {
+        FrameZone *z = &zones[(zone + n) % numZones];
+        int block;
+
+        if (order > z->maxOrder || z->numFree < (1 << order))
+            continue;
+        block = TakeBlock(z, order);
+        if (block == -1 && z->numHot > 0) {
+            // the frames we need may be sitting on the stack
+            while (z->numHot > 0)
+                GiveBlock(z, z->hot[--z->numHot], 0);
+            block = TakeBlock(z, order);
+        }
+        if (block != -1) {
+            z->numFree -= 1 << order;
+            z->numAllocs += 1 << order;
+            if (n > 0)
+                z->numForeign += 1 << order;
+            return z->base + block;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::FreeRun
+// 	Return a run got from AllocateRun(order, ...).
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::FreeRun(int frame, int order) {
+    FrameZone *z = &zones[ZoneOf(frame)];
+
+    if (order == 0) {
+        Free(frame);
+        return;
+    }
+    GiveBlock(z, frame - z->base, order);
+    z->numFree += 1 << order;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::NumFree
+// 	Return the number of free frames in all zones.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::NumFree() {
+    int count = 0;
+
+    for (int n = 0; n < numZones; n++)
+        count += zones[n].numFree;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::NeedsReclaim, FrameAllocator::Reclaimed
+// 	Has zone "zone" fallen below its low watermark?  Is it back up
+//	to its high one?
+//----------------------------------------------------------------------
+
+bool
+FrameAllocator::NeedsReclaim(int zone) {
+    return zones[zone].numFree < zones[zone].lowWater;
+}
+
+bool
+FrameAllocator::Reclaimed(int zone) {
+    return zones[zone].numFree >= zones[zone].highWater;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Print
+// 	Print each zone's watermarks and how much it was used.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Print() {
+    for (int n = 0; n < numZones; n++) {
+        FrameZone *z = &zones[n];
+
+        printf("Zone %d: frames %d-%d, %d free (low %d, high %d), "
+               "%d allocated, %d for other zones\n", n, z->base,
+               z->base + z->size - 1, z->numFree, z->lowWater, z->highWater,
+               z->numAllocs, z->numForeign);
+    }
+}
@@ -0,0 +1,95 @@
+// framealloc.h
+//	Data structures for allocating physical page frames.
+//
+//	Frames are divided into zones -- contiguous ranges, each with its
+//	own allocator and statistics, in the style of NUMA nodes.  A
+//	caller names the zone it would prefer, and gets a frame from
+//	another one only if its own is empty.
+//
+//	Within a zone, a buddy allocator manages blocks of 2^order
+//	contiguous frames, kept on one free list per order.  Single
+//	frames, by far the commonest request, come off a small stack of
+//	free frames in front of it, refilled from and drained back to the
+//	buddy lists in batches, so that allocating or freeing one costs
+//	O(1) however much memory there is.
+//
+//	Each zone has two watermarks.  When its free frames drop below
+//	"low", NeedsReclaim says so, and the caller should start freeing
+//	frames in the background until there are "high" of them again.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMEALLOC_H
+#define FRAMEALLOC_H
+
+#include "copyright.h"
+
+#define MaxFrameOrder   10      // largest block is 2^MaxFrameOrder frames
+#define HotBatch        8       // frames moved between the stack and
+                                // the buddy lists at a time
+
+// One zone of frames.
+
+class FrameZone {
+public:
+    int base;                   // first frame in the zone
+    int size;                   // frames in the zone
+    int maxOrder;               // largest block that fits
+
+    int freeHead[MaxFrameOrder + 1];    // per order: first free block, or -1
+    int *next, *prev;           // per frame: free list links, if the
+    // frame heads a free block
+    int *order;                 // per frame: order of the free block
+    // it heads, or -1
+
+    int *hot;                   // stack of free single frames
+    int numHot;
+
+    int numFree;                // counting the hot stack
+    int lowWater, highWater;
+    int numAllocs;              // frames handed out from this zone
+    int numForeign;             // ... to callers preferring another
+};
+
+// The following class defines a physical frame allocator.  Callers
+// provide their own mutual exclusion.
+
+class FrameAllocator {
+public:
+    FrameAllocator(int nFrames, int nZones);    // all frames start free
+    ~FrameAllocator();
+
+    int Allocate(int zone);     // one frame, preferably from "zone";
+    // -1 if there are none at all
+    void Free(int frame);
+
+    int AllocateRun(int order, int zone);
+    // 2^order contiguous, aligned frames;
+    // -1 if no zone has such a block
+    void FreeRun(int frame, int order);
+
+    int NumZones() { return numZones; }
+    int ZoneOf(int frame) {     // the last zone takes the remainder
+        return frame / zoneSize < numZones ? frame / zoneSize : numZones - 1;
+    }
+    int NumFree();
+    bool NeedsReclaim(int zone);    // below the low watermark?
+    bool Reclaimed(int zone);   // back up to the high watermark?
+
+    void Print();               // per-zone statistics
+
+private:
+    FrameZone *zones;
+    int numZones;
+    int zoneSize;               // frames per zone (the last may have
+    // fewer)
+
+    int TakeBlock(FrameZone *z, int order);     // buddy allocation
+    void GiveBlock(FrameZone *z, int frame, int order);
+    void Push(FrameZone *z, int frame, int order);  // onto a free list
+    void Unlink(FrameZone *z, int frame);           // off its free list
+};
+
+#endif // FRAMEALLOC_H
@@ -0,0 +1,159 @@
+// futex.cc
+//	Routines to put user processes to sleep on a word of memory, and
+//	wake them up.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "futex.h"
+#include "synch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize an empty table: nobody is waiting.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable() {
+    lock = new Lock("futex lock");
+    for (int i = 0; i < FutexBuckets; i++)
+        buckets[i] = new List;
+    numWaits = numRetries = numWakes = numWoken = 0;
+}
+
+FutexTable::~FutexTable() {
+    for (int i = 0; i < FutexBuckets; i++)
+        delete buckets[i];      // nobody can be waiting at Cleanup
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Find
+// 	Return the queue of processes waiting on the word at "physAddr";
+//	if there is none, NULL, or a new, empty one if "create".
+//
+//	Called with the lock held.
+//----------------------------------------------------------------------
+
+FutexQueue *
+FutexTable::Find(int physAddr, bool create) {
+    List *bucket = buckets[((unsigned) physAddr / 4) % FutexBuckets];
+    FutexQueue *q;
+
+    for (ListElement *e = bucket->getFirst(); e != NULL; e = e->next)
+        if (((FutexQueue *) e->item)->physAddr == physAddr)
+            return (FutexQueue *) e->item;
+    if (!create)
+        return NULL;
+    q = new FutexQueue;
+    q->physAddr = physAddr;
+    q->waiting = new Condition("futex");
+    q->asleep = q->users = 0;
+    bucket->Append((void *) q);
+    return q;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::PinWord
+// 	Find the current process's word at virtual address "addr" in
+//	physical memory, and pin its page there.  The page is made
+//	writable first: a page still shared copy-on-write with a Forked
+//	relative would otherwise put the two of them in the same queue,
+//	though their words are not the same any more once either stores.
+//----------------------------------------------------------------------
+
+char *
+FutexTable::PinWord(int addr) {
+    if (addr & 0x3)
+        return NULL;
+    return currentThread->space->PinUserPage(addr, TRUE);
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	If the caller's word at "addr" holds "expected", sleep until a
+//	Wake on the same word.  The word is read with the lock held, and
+//	Wake takes the lock too, so a Wake after the word changed can't
+//	be missed.  Returns 0 once woken; -1 at once if the word didn't
+//	hold "expected" (the caller should look at it again) or "addr"
+//	is no good.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(int addr, int expected) {
+    char *where = PinWord(addr);
+    FutexQueue *q;
+
+    if (where == NULL)
+        return -1;
+    lock->Acquire();
+    if ((int) WordToHost(*(unsigned int *) where) != expected) {
+        numRetries++;
+        lock->Release();
+        currentThread->space->UnpinUserPage(where);
+        return -1;
+    }
+    numWaits++;
+    q = Find(where - machine->mainMemory, TRUE);
+    q->asleep++;
+    q->users++;
+    q->waiting->Wait(lock);
+    if (--q->users == 0) {
+        List *bucket = buckets[((unsigned) q->physAddr / 4) % FutexBuckets];
+
+        for (int i = 1; i <= bucket->ListLength(); i++)
+            if (bucket->getItem(i) == (void *) q) {
+                bucket->RemoveItem(i);
+                break;
+            }
+        delete q->waiting;
+        delete q;
+    }
+    lock->Release();
+    currentThread->space->UnpinUserPage(where);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" of the processes waiting on the caller's word
+//	at "addr", in the order they went to sleep.  Returns how many
+//	were woken, or -1 if "addr" is no good.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(int addr, int count) {
+    char *where = PinWord(addr);
+    FutexQueue *q;
+    int woken = 0;
+
+    if (where == NULL)
+        return -1;
+    lock->Acquire();
+    numWakes++;
+    q = Find(where - machine->mainMemory, FALSE);
+    if (q != NULL) {
+        woken = min(max(count, 0), q->asleep);
+        q->asleep -= woken;
+        for (int i = 0; i < woken; i++)
+            q->waiting->Signal(lock);
+        numWoken += woken;
+    }
+    lock->Release();
+    currentThread->space->UnpinUserPage(where);
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Print
+// 	Print how often user locks were contended.  Locking and unlocking
+//	one nobody else wanted never gets this far.
+//----------------------------------------------------------------------
+
+void
+FutexTable::Print() {
+    printf("Futexes: %d waits (%d retries), %d wakes, %d woken\n",
+           numWaits, numRetries, numWakes, numWoken);
+}
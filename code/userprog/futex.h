@@ -0,0 +1,72 @@
+// futex.h
+//	Data structures for futexes ("fast user-space mutexes"): the
+//	kernel half of the locks and condition variables user programs
+//	build for themselves in memory they share (see test/usync.h).
+//
+//	A lock is just a word of user memory, updated with LL/SC; as long
+//	as nobody has to wait, the kernel never hears of it.  A process
+//	that must wait calls FutexWait on the word, which puts it to sleep
+//	-- unless the word has changed by the time the kernel looks, in
+//	which case there may be nothing to wait for, and the process goes
+//	back and looks again.  One that changes the word calls FutexWake
+//	to wake waiters.
+//
+//	Waiters are queued by the word's physical address, so processes
+//	sharing a segment (see shm.h) find each other wherever they have
+//	it mapped.  A waiter keeps its page pinned, so the address stays
+//	good until it is woken.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "list.h"
+
+class Lock;
+class Condition;
+
+#define FutexBuckets 31         // hash table size
+
+// The processes waiting on one word.
+
+class FutexQueue {
+public:
+    int physAddr;               // the word
+    Condition *waiting;         // who is asleep on it
+    int asleep;                 // ... and not yet woken
+    int users;                  // threads in Wait; the queue goes when
+                                // the last one leaves
+};
+
+// The following class defines the table of wait queues.
+
+class FutexTable {
+public:
+    FutexTable();
+    ~FutexTable();
+
+    int Wait(int addr, int expected);   // sleep until woken, if the
+    // caller's word at "addr" still holds
+    // "expected"; 0 if woken, -1 if not
+    int Wake(int addr, int count);      // wake up to "count" waiters on
+    // the word; how many were woken, or -1
+
+    void Print();               // how often anybody had to wait
+
+private:
+    Lock *lock;                 // checking the word and going to sleep
+    // are atomic with respect to Wake
+    List *buckets[FutexBuckets];
+    int numWaits, numRetries, numWakes, numWoken;
+
+    FutexQueue *Find(int physAddr, bool create);
+    char *PinWord(int addr);    // where the caller's word is, pinned;
+    // NULL if it isn't a legal, aligned
+    // word of writable memory
+};
+
+#endif // FUTEX_H
@@ -0,0 +1,60 @@
+// idalloc.cc
+//	Routines to allocate and free IDs.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "idalloc.h"
+#include "utility.h"
+
+//----------------------------------------------------------------------
+// IdAllocator::IdAllocator
+// 	Initialize an allocator for the IDs first .. last, all free, to be
+//	handed out in increasing order at first.
+//----------------------------------------------------------------------
+
+IdAllocator::IdAllocator(int first, int last) {
+    ASSERT(first <= last);
+    firstId = first;
+    size = last - first + 1;
+    queue = new int[size];
+    for (int i = 0; i < size; i++)
+        queue[i] = first + i;
+    head = 0;
+    count = size;
+}
+
+IdAllocator::~IdAllocator() {
+    delete[] queue;
+}
+
+//----------------------------------------------------------------------
+// IdAllocator::Allocate
+// 	Return the ID that has been free longest, or -1 if all are in use.
+//----------------------------------------------------------------------
+
+int
+IdAllocator::Allocate() {
+    int id;
+
+    if (count == 0)
+        return -1;
+    id = queue[head];
+    head = (head + 1) % size;
+    count--;
+    return id;
+}
+
+//----------------------------------------------------------------------
+// IdAllocator::Free
+// 	Put "id", got from Allocate, back at the end of the queue.
+//----------------------------------------------------------------------
+
+void
+IdAllocator::Free(int id) {
+    ASSERT(id >= firstId && id < firstId + size && count < size);
+    queue[(head + count) % size] = id;
+    count++;
+}
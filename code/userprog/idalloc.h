@@ -0,0 +1,37 @@
+// idalloc.h
+//	Data structures for handing out small integer IDs, such as
+//	address space (process) IDs, in constant time.
+//
+//	Free IDs wait in a circular queue, so the one handed out is the
+//	one that has been free longest: a process that Joins a recently
+//	finished child is unlikely to find its ID already reused.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef IDALLOC_H
+#define IDALLOC_H
+
+#include "copyright.h"
+
+// The following class defines an allocator for the IDs first .. last.
+// Callers provide their own mutual exclusion.
+
+class IdAllocator {
+public:
+    IdAllocator(int first, int last);   // all IDs start free
+    ~IdAllocator();
+
+    int Allocate();             // a free ID, or -1 if there are none
+    void Free(int id);          // id is no longer in use
+    int NumFree() { return count; }
+
+private:
+    int *queue;                 // the free IDs, oldest at "head"
+    int size;                   // how many IDs there are
+    int head, count;
+    int firstId;
+};
+
+#endif // IDALLOC_H
@@ -0,0 +1,116 @@
+// pipe.cc
+//	Routines to move bytes through a pipe.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pipe.h"
+#include "synch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe, with both ends open.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer() {
+    buffer = new char[PipeSize];
+    head = count = 0;
+    readerOpen = writerOpen = TRUE;
+    lock = new Lock("pipe lock");
+    notEmpty = new Condition("pipe not empty");
+    notFull = new Condition("pipe not full");
+}
+
+PipeBuffer::~PipeBuffer() {
+    delete[] buffer;
+    delete lock;
+    delete notEmpty;
+    delete notFull;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Wait until the pipe has something in it, or its write end is
+//	closed; then take up to "numBytes" bytes, as many as are there.
+//	The bytes leave the ring in at most two copies, one either side
+//	of the wrap.  Return how many were read: 0 only at the end.
+//
+//	"into" -- where the bytes go
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(char *into, int numBytes) {
+    int got, first;
+
+    lock->Acquire();
+    while (count == 0 && writerOpen)
+        notEmpty->Wait(lock);
+    got = min(numBytes, count);
+    first = min(got, PipeSize - head);
+    bcopy(&buffer[head], into, first);
+    bcopy(buffer, into + first, got - first);
+    head = (head + got) % PipeSize;
+    count -= got;
+    if (got > 0)
+        notFull->Broadcast(lock);
+    lock->Release();
+    return got;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Put "numBytes" bytes into the pipe, as much at a time as there is
+//	room for, waiting for a reader to make room when it fills.  Return
+//	how many went in -- all of them, unless the read end is closed
+//	first -- or -1 if the read end was closed to begin with.
+//
+//	"from" -- where the bytes come from
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(char *from, int numBytes) {
+    int done = 0;
+
+    lock->Acquire();
+    while (done < numBytes && readerOpen) {
+        int tail = (head + count) % PipeSize;
+        int put = min(numBytes - done, PipeSize - count);
+        int first = min(put, PipeSize - tail);
+
+        if (put == 0) {
+            notFull->Wait(lock);
+            continue;
+        }
+        bcopy(from + done, &buffer[tail], first);
+        bcopy(from + done + first, buffer, put - first);
+        count += put;
+        done += put;
+        notEmpty->Broadcast(lock);
+    }
+    lock->Release();
+    return (done == 0 && numBytes > 0) ? -1 : done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::CloseEnd
+// 	Note that no descriptor names one end of the pipe any more, and
+//	wake whoever is waiting on the other end to find out.
+//
+//	"writeEnd" -- TRUE for the write end, FALSE for the read end
+//----------------------------------------------------------------------
+
+void
+PipeBuffer::CloseEnd(bool writeEnd) {
+    lock->Acquire();
+    if (writeEnd) {
+        writerOpen = FALSE;
+        notEmpty->Broadcast(lock);      // readers see the end
+    } else {
+        readerOpen = FALSE;
+        notFull->Broadcast(lock);       // writers give up
+    }
+    lock->Release();
+}
@@ -0,0 +1,51 @@
+// pipe.h
+//	Data structures for pipes: buffers in the kernel that one user
+//	process writes and another reads, through file descriptors (see
+//	filetable.h), without going near the file system.
+//
+//	A reader waits until there is something to read, and gets what is
+//	there, up to what it asked for -- or nothing, once the write end is
+//	closed and the buffer is empty.  A writer waits for room until all
+//	it has is written, unless the read end is closed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+
+class Lock;
+class Condition;
+
+#define PipeSize 4096           // bytes a pipe can hold
+
+// The kernel's side of a pipe.  (Not "Pipe", which is the name of the
+// system call in syscall.h.)
+
+class PipeBuffer {
+public:
+    PipeBuffer();               // empty, both ends open
+    ~PipeBuffer();
+
+    int Read(char *into, int numBytes);     // wait for data, then take
+    // up to numBytes of it; 0 at the end
+    int Write(char *from, int numBytes);    // wait for room, until all
+    // of it is in; -1 if nobody reads it
+
+    void CloseEnd(bool writeEnd);   // no descriptor names the end now
+    bool Closed() { return !readerOpen && !writerOpen; }
+
+private:
+    char *buffer;               // a ring of PipeSize bytes
+    int head;                   // where the next byte to read is
+    int count;                  // how many bytes are waiting
+    bool readerOpen, writerOpen;
+    Lock *lock;
+    Condition *notEmpty;        // readers wait here
+    Condition *notFull;         // writers wait here
+};
+
+#endif // PIPE_H
@@ -14,6 +14,9 @@
 #include "addrspace.h"
 #include "synch.h"
 #include "progtest.h"
+#include "pipe.h"
+
+#include <sys/time.h>
 
 //extern AddrSpace* space;
 
@@ -26,6 +29,22 @@ void StartProcess(int spaceId) {
     ASSERT(FALSE);
 }
 
+//----------------------------------------------------------------------
+// ForkedProcess
+// 	Start running the child of a Fork: pick up the registers the
+//	parent had at the system call (saved in this thread by the Fork
+//	handler), except that Fork returns 0 here.
+//----------------------------------------------------------------------
+
+void ForkedProcess(int spaceId) {
+    currentThread->RestoreUserState();
+    machine->WriteRegister(2, 0);
+    currentThread->space->RestoreState();
+
+    machine->Run();
+    ASSERT(FALSE);
+}
+
 //----------------------------------------------------------------------
 // StartProcess
 // 	Run a user program.  Open the executable, load it into
@@ -43,11 +62,9 @@ StartProcess(char *filename) {
     }
     // lab6: 使用这个可执行文件创建一个新的地址空间，
     //  立刻删掉这个可执行文件了
-    space = new AddrSpace(executable);
+    space = new AddrSpace(executable);    // the space owns executable
     currentThread->space = space;
 
-    delete executable;            // close file
-
     // lab6：设置 machine 的寄存器
     //  设置 machine 的页表
     space->InitRegisters();        // set the initial register values
@@ -97,3 +114,146 @@ ConsoleTest(char *in, char *out) {
         if (ch == 'q') return;  // if q, quit
     }
 }
+
+//----------------------------------------------------------------------
+// PageTableBench
+// 	Compare the page table layout built in (see pagetable.h) with a
+//	plain linear array, as the machine used to index: host time per
+//	lookup, and memory taken.  Two address spaces are measured, a
+//	small dense one and a large sparse one -- code and data at the
+//	bottom, stack at the top, nothing in between.
+//----------------------------------------------------------------------
+
+#if defined(TWO_LEVEL_PAGE_TABLE)
+#define PageTableLayout "two-level"
+#elif defined(HASHED_PAGE_TABLE)
+#define PageTableLayout "hashed"
+#else
+#define PageTableLayout "linear"
+#endif
+
+#define PageTableBenchLookups   2000000
+
+static volatile int benchSink;  // keeps the lookups from being optimized away
+
+static double
+ElapsedNs(struct timeval *start, struct timeval *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 +
+           (end->tv_usec - start->tv_usec) * 1e3;
+}
+
+static void
+PageTableBenchShape(char *name, unsigned int numPages, unsigned int low,
+                    unsigned int high) {
+    PageTable *table = new PageTable(numPages);
+    TranslationEntry *linear = new TranslationEntry[numPages];
+    unsigned int *used = new unsigned int[low + high];
+    struct timeval start, end;
+    double tableNs, linearNs;
+    int i, sum;
+
+    // pages 0 .. low-1 and the top "high" pages are mapped
+    for (i = 0; i < (int) (low + high); i++) {
+        used[i] = (i < (int) low) ? i : numPages - (low + high) + i;
+        TranslationEntry *entry = table->Entry(used[i]);
+        entry->physicalPage = used[i] % NumPhysPages;
+        entry->valid = TRUE;
+    }
+    for (i = 0; i < (int) numPages; i++) {
+        linear[i].physicalPage = i % NumPhysPages;
+        linear[i].valid = TRUE;
+    }
+
+    gettimeofday(&start, NULL);
+    for (i = 0, sum = 0; i < PageTableBenchLookups; i++) {
+        TranslationEntry *entry = table->Lookup(used[i % (low + high)]);
+        if (entry != NULL && entry->valid)
+            sum += entry->physicalPage;
+    }
+    gettimeofday(&end, NULL);
+    tableNs = ElapsedNs(&start, &end) / PageTableBenchLookups;
+    benchSink = sum;
+
+    gettimeofday(&start, NULL);
+    for (i = 0, sum = 0; i < PageTableBenchLookups; i++) {
+        unsigned int vpn = used[i % (low + high)];
+        if (vpn < numPages && linear[vpn].valid)
+            sum += linear[vpn].physicalPage;
+    }
+    gettimeofday(&end, NULL);
+    linearNs = ElapsedNs(&start, &end) / PageTableBenchLookups;
+    benchSink = sum;
+
+    printf("%s: %u pages, %u mapped\n", name, numPages, low + high);
+    printf("  %-9s page table: %6.2f ns/lookup, %8d bytes (%d entries)\n",
+           PageTableLayout, tableNs, table->Overhead(), table->NumEntries());
+    printf("  linear array:         %6.2f ns/lookup, %8d bytes\n", linearNs,
+           (int) (numPages * sizeof(TranslationEntry)));
+
+    delete table;
+    delete[] linear;
+    delete[] used;
+}
+
+void
+PageTableBench() {
+    PageTableBenchShape("Dense", 64, 64, 0);
+    PageTableBenchShape("Sparse", 1 << 18, 48, 16);
+}
+
+//----------------------------------------------------------------------
+// PipeBench
+// 	Measure pipe bandwidth: a kernel thread writes PipeBenchBytes
+//	through a pipe while this one reads them, both a chunk of the same
+//	size at a time, and report host time and simulated ticks for a
+//	range of chunk sizes.  PipeBuffer::Read and PipeBuffer::Write are
+//	what the Read and Write system calls use on a pipe, with the
+//	user's pages in place of the buffers here.
+//----------------------------------------------------------------------
+
+#define PipeBenchBytes  (4 * 1024 * 1024)
+
+static int pipeBenchChunk;      // bytes per Read or Write
+
+static void
+PipeBenchWriter(_int arg) {
+    PipeBuffer *pipe = (PipeBuffer *) arg;
+    char *buffer = new char[pipeBenchChunk];
+
+    bzero(buffer, pipeBenchChunk);
+    for (int done = 0; done < PipeBenchBytes; done += pipeBenchChunk)
+        pipe->Write(buffer, pipeBenchChunk);
+    pipe->CloseEnd(TRUE);
+    delete[] buffer;
+}
+
+void
+PipeBench() {
+    static int chunks[] = {16, 128, 1024, PipeSize, 4 * PipeSize};
+
+    for (int c = 0; c < (int) (sizeof(chunks) / sizeof(int)); c++) {
+        PipeBuffer *pipe = new PipeBuffer;
+        char *buffer = new char[chunks[c]];
+        struct timeval start, end;
+        int startTicks, got, total = 0;
+        double nsecs;
+
+        pipeBenchChunk = chunks[c];
+        startTicks = stats->totalTicks;
+        gettimeofday(&start, NULL);
+        (new Thread("pipe writer"))->Fork(PipeBenchWriter, (_int) pipe);
+        while ((got = pipe->Read(buffer, chunks[c])) > 0)
+            total += got;
+        gettimeofday(&end, NULL);
+        ASSERT(total == PipeBenchBytes);
+
+        nsecs = ElapsedNs(&start, &end);
+        printf("Pipe, %6d-byte chunks: %8.1f MB/s (host), "
+               "%7.2f bytes/tick\n", chunks[c],
+               PipeBenchBytes / (nsecs / 1e9) / (1024 * 1024),
+               (double) PipeBenchBytes / (stats->totalTicks - startTicks));
+        pipe->CloseEnd(FALSE);
+        delete pipe;
+        delete[] buffer;
+    }
+}
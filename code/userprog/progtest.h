@@ -6,6 +6,7 @@
 #define NACHOS_PROGTEST_H
 
 extern void StartProcess(int spaceId);
+extern void ForkedProcess(int spaceId);
 
 extern AddrSpace *space;
 
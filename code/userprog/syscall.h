@@ -29,6 +29,21 @@
 #define SC_Close    8
 #define SC_Fork        9
 #define SC_Yield    10
+#define SC_Sleep    11
+#define SC_ProcStat    12
+#define SC_MemStat    13
+#define SC_Mmap        14
+#define SC_Munmap    15
+#define SC_ReadV    16
+#define SC_WriteV    17
+#define SC_Pipe        18
+#define SC_Dup        19
+#define SC_ShmCreate    20
+#define SC_ShmAttach    21
+#define SC_ShmDetach    22
+#define SC_FutexWait    23
+#define SC_FutexWake    24
+#define SC_Sbrk        25
 
 #ifndef IN_ASM
 
@@ -64,6 +79,14 @@ SpaceId Exec(char *name);
  */
 int Join(SpaceId id);
 
+/* Create a new process running the same program as this one, with a
+ * copy of its memory (shared copy-on-write, so this is cheap) and its
+ * registers.  Both return from Fork: the parent with the child's
+ * SpaceId (or -1 if there is no virtual memory to do it with), the
+ * child with 0.  The child starts with only the console open.
+ */
+SpaceId Fork();
+
 
 /* File system operations: Create, Open, Read, Write, Close
  * These functions are patterned after UNIX -- files represent
@@ -94,8 +117,10 @@ void Create(char *name);
  */
 OpenFileId Open(char *name);
 
-/* Write "size" bytes from "buffer" to the open file. */
-void Write(char *buffer, int size, OpenFileId id);
+/* Write "size" bytes from "buffer" to the open file.  Return the number
+ * of bytes written.
+ */
+int Write(char *buffer, int size, OpenFileId id);
 
 /* Read "size" bytes from the open file into "buffer".  
  * Return the number of bytes actually read -- if the open file isn't
@@ -108,22 +133,175 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* One piece of a buffer scattered through memory, for ReadV and WriteV. */
+typedef struct {
+    char *base;
+    int len;
+} IoVec;
+
+#define MaxIoVecs    16
 
+/* Write the "count" pieces "iov" describes to the open file, in order,
+ * as one Write of them all laid end to end would.  Return the number
+ * of bytes written, or -1 if "count" is more than MaxIoVecs.
+ */
+int WriteV(IoVec *iov, int count, OpenFileId id);
+
+/* Read from the open file into the "count" pieces "iov" describes, in
+ * order, stopping early where a Read would.  Return the number of bytes
+ * read, or -1 if "count" is more than MaxIoVecs.
+ */
+int ReadV(IoVec *iov, int count, OpenFileId id);
 
-/* User-level thread operations: Fork and Yield.  To allow multiple
- * threads to run within a user program. 
+/* Make a pipe: bytes written to fds[1] can be read, in order, from
+ * fds[0].  A Read of an empty pipe waits for something to be written,
+ * and returns 0 once every descriptor on the write end is closed; a
+ * Write to a full one waits for room.  Return 0, or -1 if the process
+ * has too many files open.
  */
+int Pipe(OpenFileId fds[2]);
 
-/* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+/* Return the lowest unused OpenFileId, now naming what "id" does (and
+ * sharing its position in a file), or -1 if "id" isn't open or the
+ * process has too many files open.  Exec'd programs start with their
+ * ConsoleInput and ConsoleOutput naming what the caller's do, so a
+ * shell can Close one of those and Dup a pipe end into its place.
+ */
+OpenFileId Dup(OpenFileId id);
+
+
+
+/* User-level thread operations: Yield.  (Fork, above, makes a new
+ * process rather than a thread in this one.)
  */
-void Fork(void (*func)());
 
 /* Yield the CPU to another runnable thread, whether in this address space 
  * or not. 
  */
 void Yield();
 
+/* Block the calling thread for "ticks" units of simulated time, 
+ * without consuming the CPU.  Other threads run in the meantime; if 
+ * there are none, the clock simply skips ahead.
+ */
+void Sleep(int ticks);
+
+
+/* CPU and scheduling accounting for one process, as kept by the
+ * kernel scheduler.  Times are in simulated ticks.
+ */
+typedef struct {
+    int userTicks;              /* ticks executing user code */
+    int systemTicks;            /* ticks executing in the kernel */
+    int readyTicks;             /* ticks waiting on the ready list */
+    int blockedTicks;           /* ticks blocked (I/O, Join, Sleep...) */
+    int voluntarySwitches;      /* CPU given up by blocking or Yield */
+    int involuntarySwitches;    /* CPU taken away by the timer */
+    int pageFaults;             /* page faults taken */
+} ProcStats;
+
+/* Copy the accounting of process "id" (or of the caller, if "id" is -1)
+ * into "stats".  Return 0, or -1 if there is no such process.
+ */
+int ProcStat(SpaceId id, ProcStats *stats);
+
+
+/* Paging activity of one process, as kept by the virtual memory system.
+ * A major fault had to read the page from disk; a minor one did not.
+ */
+typedef struct {
+    int residentPages;          /* pages in physical memory now */
+    int majorFaults;
+    int minorFaults;
+    int swapIns;                /* pages read from swap */
+    int swapOuts;               /* pages written to swap */
+    int workingSet;             /* pages used in the last sample interval */
+    int frameLimit;             /* frames the kernel lets it have */
+} MemStats;
+
+/* Copy the paging activity of process "id" (or of the caller, if "id"
+ * is -1) into "stats".  Return 0, or -1 if there is no such process
+ * (or no virtual memory).
+ */
+int MemStat(SpaceId id, MemStats *stats);
+
+
+/* Map "length" bytes of the open file "id", from "offset" on (a multiple
+ * of the page size), into the address space, and return where.  Pages
+ * are read from the file as they are touched; pages written are saved
+ * back to the file when they are unmapped, or the process exits.  Bytes
+ * mapped beyond the end of the file read as zeros, and are not saved.
+ * The file may be closed while it is mapped.  Return (char *) -1 on
+ * failure.
+ */
+char *Mmap(OpenFileId id, int offset, int length);
+
+/* Undo the Mmap that returned "addr".  Return 0, or -1 if there is no
+ * such mapping.
+ */
+int Munmap(char *addr);
+
+
+/* Shared memory: a segment of memory that several processes map at
+ * once, so that they can pass data to each other by simply storing it
+ * (guarding it with Yield, Join or a pipe, as it stands).  A segment
+ * is named by a "key" the processes agree on; a child made by Fork
+ * shares its parent's segments, at the same addresses.  A segment is
+ * gone once every process has detached it (or exited).
+ */
+
+/* Make a new segment called "key", "size" bytes long and all zeros, and
+ * map it into the address space.  Return where, or (char *) -1 if there
+ * already is a segment called "key", or no memory for it.
+ */
+char *ShmCreate(int key, int size);
+
+/* Map the existing segment called "key" into the address space, and
+ * return where; (char *) -1 if there is no such segment.
+ */
+char *ShmAttach(int key);
+
+/* Unmap the segment that ShmCreate or ShmAttach put at "addr".  Return
+ * 0, or -1 if there is none there.
+ */
+int ShmDetach(char *addr);
+
+
+/* Move the break -- the end of the heap, which starts out empty just
+ * above the program's uninitialized data -- by "increment" bytes (which
+ * may be negative), and return where it was.  Memory the heap grows into
+ * reads as zeros; memory it shrinks out of is given back.  The heap
+ * may grow to 128K bytes (HeapRegionSize), up to the stack.  Return
+ * (char *) -1, leaving the break where it is, if it can't move that
+ * far.  malloc.h hands out memory from here.
+ */
+char *Sbrk(int increment);
+
+
+/* Futexes: the kernel's part in locks that user programs keep in their
+ * own (shared) memory, and update atomically with CompareAndSwap.
+ * Only a process that has to wait, or to wake a waiter, makes a
+ * syscall; test/usync.h builds mutexes and condition variables on them.
+ * The word at "addr" must be aligned.
+ */
+
+/* Sleep until a FutexWake on the word at "addr" -- but only if it still
+ * holds "expected".  Return 0 once woken, or -1 at once if the word has
+ * changed (or "addr" is bad).
+ */
+int FutexWait(int *addr, int expected);
+
+/* Wake up to "count" processes sleeping on the word at "addr".  Return
+ * how many were woken, or -1 if "addr" is bad.
+ */
+int FutexWake(int *addr, int count);
+
+/* Not a syscall: if the word at "addr" holds "old", replace it with
+ * "value", atomically (using the LL/SC instructions).  Return what the
+ * word held, so the swap happened if that is "old".
+ */
+int CompareAndSwap(int *addr, int old, int value);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,586 @@
+// frametable.cc
+//	Routines to allocate physical page frames and choose pages to
+//	evict.
+//
+//	The machine sets the use and dirty bits in whichever translation
+//	it used -- with a TLB, the TLB's copy -- so those are folded back
+//	into the page tables before every search for a victim.  Evicting
+//	or cleaning a page is left to the address space that owns it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "system.h"
+#include "synch.h"
+
+static char *policyNames[] = {"fifo", "clock", "eclock", "wsclock"};
+
+//----------------------------------------------------------------------
+// ReplacePolicyNamed
+// 	Look up replacement policy "name", as given to -vr.
+//----------------------------------------------------------------------
+
+bool
+ReplacePolicyNamed(char *name, ReplacePolicy *policy) {
+    for (int i = 0; i <= WSClockReplace; i++)
+        if (!strcmp(name, policyNames[i])) {
+            *policy = (ReplacePolicy) i;
+            return TRUE;
+        }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table, with every frame free.
+//
+//	"nFrames" -- how many of the machine's physical pages to use
+//	"replace" -- how to choose a page to evict
+//	"nZones" -- how many allocation zones to divide the frames into
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable(int nFrames, ReplacePolicy replace, int nZones) {
+    ASSERT(nFrames > 0 && nFrames <= NumPhysPages);
+    numFrames = nFrames;
+    policy = replace;
+    frames = new FrameInfo[numFrames];
+    for (int i = 0; i < numFrames; i++) {
+        frames[i].owner = NULL;
+        frames[i].refCount = 0;
+        frames[i].sharers = new List;
+        frames[i].pinCount = 0;
+        frames[i].textSector = -1;
+        frames[i].segment = FALSE;
+    }
+    hand = 0;
+    loadCount = 0;
+    numEvictions = numLocalEvictions = numDropped = 0;
+    numRuns = 0;
+    allocator = new FrameAllocator(numFrames, nZones);
+    reclaimWanted = new Semaphore("page daemon", 0);
+    daemonWoken = FALSE;
+    reclaimZone = -1;
+    localSpace = NULL;
+    numReclaimed = 0;
+}
+
+FrameTable::~FrameTable() {
+    for (int i = 0; i < numFrames; i++)
+        delete frames[i].sharers;
+    delete[] frames;
+    delete allocator;
+    delete reclaimWanted;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::StartPageDaemon
+// 	Fork the page daemon.  Called once the paging lock exists.
+//----------------------------------------------------------------------
+
+static void
+RunPageDaemon(int arg) {
+    frameTable->PageDaemon();
+}
+
+void
+FrameTable::StartPageDaemon() {
+    Thread *t = new Thread("page daemon");
+
+    t->Fork(RunPageDaemon, 0);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::PageDaemon
+// 	Sleep until some zone drops below its low watermark, then evict
+//	pages from each such zone until it is back up to its high one
+//	(or nothing there can be evicted), and sleep again.
+//----------------------------------------------------------------------
+
+void
+FrameTable::PageDaemon() {
+    for (;;) {
+        reclaimWanted->P();
+        pagingLock->Acquire();
+        for (int zone = 0; zone < allocator->NumZones(); zone++) {
+            if (!allocator->NeedsReclaim(zone))
+                continue;
+            reclaimZone = zone;
+            while (!allocator->Reclaimed(zone)) {
+                int frame = FindVictim();
+                if (frame == -1)
+                    break;
+                Evict(frame);
+                allocator->Free(frame);
+                numReclaimed++;
+            }
+            DEBUG('v', "Page daemon: zone %d reclaimed\n", zone);
+        }
+        reclaimZone = -1;
+        daemonWoken = FALSE;
+        pagingLock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::CheckWatermarks
+// 	Wake the page daemon if a zone is below its low watermark and it
+//	isn't already on the way.
+//----------------------------------------------------------------------
+
+void
+FrameTable::CheckWatermarks() {
+    if (daemonWoken)
+        return;
+    for (int zone = 0; zone < allocator->NumZones(); zone++)
+        if (allocator->NeedsReclaim(zone)) {
+            daemonWoken = TRUE;
+            reclaimWanted->V();
+            return;
+        }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Allocate
+// 	Find a frame for virtual page "vpn" of "owner": a free one if
+//	there is one, preferably in owner's zone, otherwise one whose page
+//	the policy gives up.  The frame is returned pinned, so nothing can
+//	take it while the caller fills it in.
+//----------------------------------------------------------------------
+
+int
+FrameTable::Allocate(AddrSpace *owner, unsigned int vpn) {
+    int frame = allocator->Allocate(owner->getSpaceID() %
+                                    allocator->NumZones());
+
+    CheckWatermarks();
+    if (frame == -1) {          // the page daemon fell behind
+        frame = FindVictim();
+        if (frame == -1) {
+            printf("Every page frame is pinned!\n");
+            ASSERT(FALSE);
+        }
+        Evict(frame);
+        numEvictions++;
+    }
+    Claim(frame, owner, vpn);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateRun
+// 	Find 2^order contiguous free frames for the virtual pages of
+//	"owner" from "vpn" on -- a superpage -- and return the first,
+//	with all of them pinned.  Pages are never evicted to make a run:
+//	if the allocator has none, return -1, and the caller makes do
+//	with single frames.  Once allocated, the frames are managed (and
+//	evicted, and freed) one by one like any others.
+//
+//	With "order" 0, this is a way to get one frame only if it is
+//	free, as fetching pages ahead of a fault does.
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateRun(AddrSpace *owner, unsigned int vpn, int order) {
+    int frame = allocator->AllocateRun(order, owner->getSpaceID() %
+                                              allocator->NumZones());
+
+    if (frame == -1)
+        return -1;
+    CheckWatermarks();
+    for (int i = 0; i < (1 << order); i++)
+        Claim(frame + i, owner, vpn + i);
+    if (order > 0)
+        numRuns++;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateShared
+// 	Find a frame for a page of a shared memory segment being created
+//	by "creator", evicting some other page if need be.  It stays
+//	pinned as long as it is part of the segment, and starts with no
+//	references: each process attaching the segment Shares it.
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateShared(AddrSpace *creator) {
+    int frame = Allocate(creator, 0);
+
+    frames[frame].owner = NULL;
+    frames[frame].refCount = 0;
+    frames[frame].segment = TRUE;
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::AllocateLocal
+// 	Find a frame for virtual page "vpn" of "owner", which is using
+//	all the frames its controller allows it: the policy picks one of
+//	owner's own pages to give up.  If none of them can go (they are
+//	all pinned or shared), fall back on Allocate.
+//----------------------------------------------------------------------
+
+int
+FrameTable::AllocateLocal(AddrSpace *owner, unsigned int vpn) {
+    int frame;
+
+    localSpace = owner;
+    frame = FindVictim();
+    localSpace = NULL;
+    if (frame == -1)
+        return Allocate(owner, vpn);
+    Evict(frame);
+    numLocalEvictions++;
+    Claim(frame, owner, vpn);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Drop
+// 	Evict the page in "frame" and free the frame, to shrink its
+//	owner's working set.  Returns FALSE, doing nothing, if the frame
+//	is pinned, or mapped by more than one process.
+//----------------------------------------------------------------------
+
+bool
+FrameTable::Drop(int frame) {
+    if (frames[frame].pinCount > 0 || frames[frame].refCount != 1)
+        return FALSE;
+    Evict(frame);
+    allocator->Free(frame);
+    numDropped++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Touched
+// 	The page in "frame" has been seen used, by someone clearing its
+//	use bit other than the replacement policy; note when, for WSClock.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Touched(int frame) {
+    frames[frame].lastUsed = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Claim
+// 	Record that "frame" now holds page "vpn" of "owner", pinned
+//	until the caller has filled it in.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Claim(int frame, AddrSpace *owner, unsigned int vpn) {
+    frames[frame].owner = owner;
+    frames[frame].vpn = vpn;
+    frames[frame].refCount = 1;
+    frames[frame].pinCount = 1;
+    frames[frame].loadedAt = loadCount++;
+    frames[frame].lastUsed = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Evict
+// 	Take "frame" back from every page table that maps it, and out of
+//	the text page cache if it is there.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Evict(int frame) {
+    FrameInfo *f = &frames[frame];
+
+    if (f->owner != NULL) {
+        DEBUG('v', "Evicting page %d of process %d from frame %d\n",
+              f->vpn, f->owner->getSpaceID(), frame);
+        f->owner->Evict(f->vpn);
+        while (!f->sharers->IsEmpty())  // only ever code pages
+            ((AddrSpace *) f->sharers->Remove())->Evict(f->vpn);
+    }
+    if (f->textSector != -1) {
+        textCache->Remove(f->textSector, f->textOffset);
+        f->textSector = -1;
+    }
+    f->owner = NULL;
+    f->refCount = 0;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Share
+// 	Record that "space" now maps "frame" as well, at virtual page
+//	"vpn" -- the same page as any other mapping, unless the frame is
+//	part of a shared memory segment, which only needs counting.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Share(int frame, AddrSpace *space, unsigned int vpn) {
+    FrameInfo *f = &frames[frame];
+
+    if (f->segment) {                   // nobody to evict it from
+        ASSERT(f->owner == NULL);
+    } else if (f->owner == NULL) {             // a cached page nobody maps
+        ASSERT(f->textSector != -1);
+        f->owner = space;
+        f->vpn = vpn;
+    } else {
+        ASSERT(f->vpn == vpn);
+        f->sharers->Append((void *) space);
+    }
+    f->refCount++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Cache, FrameTable::Uncache
+// 	Put "frame" in the text page cache under (sector, offset), or
+//	note that the cache has dropped it.  An uncached frame nobody
+//	maps is free.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Cache(int frame, int sector, int offset) {
+    frames[frame].textSector = sector;
+    frames[frame].textOffset = offset;
+    textCache->Insert(sector, offset, frame);
+}
+
+void
+FrameTable::Uncache(int frame) {
+    frames[frame].textSector = -1;
+    if (frames[frame].owner == NULL)
+        allocator->Free(frame);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	"space" has stopped mapping "frame".  If it was the owner, one of
+//	the sharers takes over; if it was the last, the frame is free.
+//	A segment's frame is free once the last process attaching the
+//	segment has detached it.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Free(int frame, AddrSpace *space) {
+    FrameInfo *f = &frames[frame];
+
+    ASSERT(frame >= 0 && frame < numFrames &&
+           (f->owner != NULL || f->segment));
+    if (f->segment) {
+        ASSERT(f->refCount > 0);
+        if (--f->refCount == 0) {
+            f->segment = FALSE;
+            f->pinCount = 0;
+            allocator->Free(frame);
+        }
+    } else if (--f->refCount == 0) {
+        ASSERT(f->owner == space);
+        f->owner = NULL;                // still cached, if it was
+        f->pinCount = 0;
+        if (f->textSector == -1)
+            allocator->Free(frame);
+    } else if (f->owner == space) {
+        f->owner = (AddrSpace *) f->sharers->Remove();
+    } else {
+        for (int i = 1; i <= f->sharers->ListLength(); i++)
+            if (f->sharers->getItem(i) == (void *) space) {
+                f->sharers->RemoveItem(i);
+                return;
+            }
+        ASSERT(FALSE);          // space didn't map the frame
+    }
+}
+
+void
+FrameTable::Pin(int frame) {
+    frames[frame].pinCount++;
+}
+
+void
+FrameTable::Unpin(int frame) {
+    ASSERT(frames[frame].pinCount > 0);
+    frames[frame].pinCount--;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Evictable, FrameTable::EntryFor
+// 	Whether "frame" may be chosen as a victim, and the translation
+//	that maps it.  A copy-on-write frame is left alone while shared:
+//	evicting it would mean saving the page for each of its sharers.
+//	Cached code pages are clean, so they can always go; one that no
+//	process maps counts as unused.
+//----------------------------------------------------------------------
+
+bool
+FrameTable::Evictable(int frame) {
+    if (frames[frame].pinCount > 0)
+        return FALSE;
+    if (reclaimZone != -1 && allocator->ZoneOf(frame) != reclaimZone)
+        return FALSE;
+    if (localSpace != NULL && (frames[frame].owner != localSpace ||
+                               frames[frame].refCount != 1))
+        return FALSE;
+    if (frames[frame].textSector != -1)
+        return TRUE;
+    return frames[frame].owner != NULL && frames[frame].refCount == 1;
+}
+
+static TranslationEntry unmapped;   // never used, never dirty
+
+TranslationEntry *
+FrameTable::EntryFor(int frame) {
+    if (frames[frame].owner == NULL)
+        return &unmapped;
+    return frames[frame].owner->PageEntry(frames[frame].vpn);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::FindVictim
+// 	Pick a frame to evict, according to the policy.  Returns -1 if
+//	every frame is pinned.
+//----------------------------------------------------------------------
+
+int
+FrameTable::FindVictim() {
+#ifdef USE_TLB
+    tlbManager->Sync();         // get the latest use and dirty bits
+#endif
+    switch (policy) {
+        case FIFOReplace:
+            return VictimFIFO();
+        case ClockReplace:
+            return VictimClock();
+        case EnhancedClockReplace:
+            return VictimEnhancedClock();
+        case WSClockReplace:
+            return VictimWSClock();
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::VictimFIFO
+// 	The evictable frame that was filled longest ago.
+//----------------------------------------------------------------------
+
+int
+FrameTable::VictimFIFO() {
+    int victim = -1;
+
+    for (int i = 0; i < numFrames; i++)
+        if (Evictable(i) &&
+            (victim == -1 || frames[i].loadedAt < frames[victim].loadedAt))
+            victim = i;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::VictimClock
+// 	Sweep the hand around the frames, clearing use bits, until it
+//	finds a page that has not been used since the last sweep.  Two
+//	full turns clear every use bit, so only pinning stops it.
+//----------------------------------------------------------------------
+
+int
+FrameTable::VictimClock() {
+    for (int n = 0; n <= 2 * numFrames; n++) {
+        int frame = hand;
+        hand = (hand + 1) % numFrames;
+        if (!Evictable(frame))
+            continue;
+        TranslationEntry *entry = EntryFor(frame);
+        if (!entry->use)
+            return frame;
+        entry->use = FALSE;     // second chance
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::VictimEnhancedClock
+// 	Classify pages by (use, dirty).  First look for a (0,0) page --
+//	cheap to evict, not recently used -- without touching anything;
+//	then for a (0,1) page, clearing use bits on the way.  Repeat once,
+//	by which time every use bit is clear.
+//----------------------------------------------------------------------
+
+int
+FrameTable::VictimEnhancedClock() {
+    for (int round = 0; round < 2; round++) {
+        for (int n = 0; n < numFrames; n++) {
+            int frame = hand;
+            hand = (hand + 1) % numFrames;
+            if (!Evictable(frame))
+                continue;
+            TranslationEntry *entry = EntryFor(frame);
+            if (!entry->use && !entry->dirty)
+                return frame;
+        }
+        for (int n = 0; n < numFrames; n++) {
+            int frame = hand;
+            hand = (hand + 1) % numFrames;
+            if (!Evictable(frame))
+                continue;
+            TranslationEntry *entry = EntryFor(frame);
+            if (!entry->use && entry->dirty)
+                return frame;
+            entry->use = FALSE;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::VictimWSClock
+// 	Clock over the working set.  A used page is in the working set:
+//	clear its bit and note the time.  An unused page older than
+//	WSClockWindow is out of it: evict it if clean, or write it back
+//	so that it is clean next time around.  If two turns find nothing,
+//	fall back on the page unused the longest.
+//
+//	Real WSClock starts the write-backs and keeps going; here they
+//	are synchronous, so a dirty page found late in a sweep holds up
+//	the fault.
+//----------------------------------------------------------------------
+
+int
+FrameTable::VictimWSClock() {
+    int now = stats->totalTicks;
+    int oldest = -1;
+
+    for (int n = 0; n < 2 * numFrames; n++) {
+        int frame = hand;
+        hand = (hand + 1) % numFrames;
+        if (!Evictable(frame))
+            continue;
+        TranslationEntry *entry = EntryFor(frame);
+        if (entry->use) {
+            entry->use = FALSE;
+            frames[frame].lastUsed = now;
+        } else if (now - frames[frame].lastUsed > WSClockWindow) {
+            if (!entry->dirty)
+                return frame;
+            frames[frame].owner->CleanPage(frames[frame].vpn);
+        }
+        if (Evictable(frame) && (oldest == -1 ||
+                                 frames[frame].lastUsed < frames[oldest].lastUsed))
+            oldest = frame;
+    }
+    return oldest;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Print
+// 	Print paging statistics, to compare replacement policies.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Print() {
+    printf("Paging: %s replacement, %d frames of %d bytes, %d faults, "
+           "%d evictions (%d local), %d reclaimed in the background, "
+           "%d trimmed, %d superpages, %d swap reads, %d swap writes\n",
+           policyNames[policy], numFrames, PageSize, stats->numPageFaults,
+           numEvictions + numLocalEvictions, numLocalEvictions, numReclaimed,
+           numDropped, numRuns, swapSpace->numPageIns, swapSpace->numPageOuts);
+    allocator->Print();
+}
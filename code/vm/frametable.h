@@ -0,0 +1,154 @@
+// frametable.h
+//	Data structures for keeping track of physical page frames under
+//	demand paging: which address space and virtual page each frame
+//	holds, and which frame to take back when memory runs out.
+//
+//	The replacement policy is chosen at startup (-vr):
+//
+//	  fifo    -- evict the page that has been resident longest
+//	  clock   -- second chance, using TranslationEntry::use
+//	  eclock  -- enhanced clock: prefer pages that are neither used
+//		     nor dirty, then unused dirty ones
+//	  wsclock -- clock over the working set: a page unused for more
+//		     than WSClockWindow ticks is evicted if clean, and
+//		     written back (cleaned) if dirty
+//
+//	Free frames come from a FrameAllocator, split into zones (-vz);
+//	each process prefers the zone its spaceID picks.  When a zone runs
+//	low, a page daemon thread evicts pages from it in the background,
+//	so that faults seldom have to wait for an eviction themselves.
+//
+//	Each process may also be held to a number of frames of its own,
+//	set by its page-fault-frequency controller (see AddrSpace).  A
+//	process at its limit replaces one of its own pages when it faults
+//	(AllocateLocal), rather than taking a free frame.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "translate.h"
+#include "list.h"
+#include "framealloc.h"
+
+class AddrSpace;
+class Semaphore;
+
+enum ReplacePolicy { FIFOReplace, ClockReplace, EnhancedClockReplace,
+                     WSClockReplace };
+
+#define WSClockWindow   5000    // ticks a page may go unused and still
+                                // count as part of the working set
+
+// Look up a policy by its -vr name; FALSE if there is no such policy.
+extern bool ReplacePolicyNamed(char *name, ReplacePolicy *policy);
+
+// What one physical frame holds.  After a Fork, parent and child
+// map the same frame at the same virtual page until one of them
+// writes it (copy-on-write); such a frame has several references,
+// and stays put until all but one have gone.  A frame in the text
+// page cache may be mapped by any number of processes running that
+// program, or by none; it can be evicted either way.  A frame of a
+// shared memory segment (see shm.h) has no owner: each process that
+// attaches the segment maps it, at whatever page it likes, and holds
+// a reference; it is never evicted, and is free once nobody does.
+
+class FrameInfo {
+public:
+    AddrSpace *owner;           // NULL if no page table maps the frame
+    unsigned int vpn;           // which of owner's pages
+    int refCount;               // page tables mapping the frame
+    List *sharers;              // the ones other than owner's
+    int pinCount;               // > 0 means the frame may not be evicted
+    int textSector;             // if in the text page cache, its key;
+    int textOffset;             // otherwise textSector is -1
+    bool segment;               // part of a shared memory segment
+    int loadedAt;               // order frames were filled in, for FIFO
+    int lastUsed;               // tick the page was last seen used, for
+                                // WSClock
+};
+
+// The following class defines the frame table.  Callers hold the
+// paging lock, so only one fault or eviction is in progress at a time.
+
+class FrameTable {
+public:
+    FrameTable(int nFrames, ReplacePolicy replace, int nZones);
+    ~FrameTable();
+
+    void StartPageDaemon();     // fork the background reclaimer
+    void PageDaemon();          // its body; never returns
+
+    int Allocate(AddrSpace *owner, unsigned int vpn);
+    // return a frame for owner's page vpn,
+    // evicting some other page if need be;
+    // the frame comes back pinned
+    int AllocateRun(AddrSpace *owner, unsigned int vpn, int order);
+    // return the first of 2^order free,
+    // contiguous frames for owner's pages
+    // vpn on, pinned; -1 if there is no
+    // such run free (nothing is evicted)
+    int AllocateShared(AddrSpace *creator);
+    // return a frame for a shared memory
+    // segment, pinned for good and mapped
+    // by nobody yet
+    int AllocateLocal(AddrSpace *owner, unsigned int vpn);
+    // like Allocate, but evict one of
+    // owner's own pages if it can
+    bool Drop(int frame);       // evict the page in the frame and free
+    // it, unless it is pinned or shared
+    void Share(int frame, AddrSpace *space, unsigned int vpn);
+    // space maps the frame too, at the
+    // same vpn (any vpn, for a segment)
+    void Free(int frame, AddrSpace *space);
+    // space no longer maps the frame; it is
+    // free once nobody does, unless cached
+    int RefCount(int frame) { return frames[frame].refCount; }
+    int NumFrames() { return numFrames; }
+    void Touched(int frame);    // its page was seen used just now
+
+    void Cache(int frame, int sector, int offset);
+    // the frame holds a code page, in
+    // the text page cache
+    void Uncache(int frame);    // not any more
+
+    void Pin(int frame);        // keep the frame where it is
+    void Unpin(int frame);
+
+    void Print();               // paging statistics
+
+private:
+    int numFrames;
+    FrameInfo *frames;
+    ReplacePolicy policy;
+    int hand;                   // where the clock policies resume
+    int loadCount;              // frames filled so far
+    int numEvictions;           // by faulting processes
+    int numLocalEvictions;      // ... of their own pages
+    int numDropped;             // pages trimmed from working sets
+    int numRuns;                // runs handed out by AllocateRun
+    FrameAllocator *allocator;  // the free frames
+    Semaphore *reclaimWanted;   // wakes the page daemon
+    bool daemonWoken;           // ... and it hasn't finished yet
+    int reclaimZone;            // if not -1, victims must be in this zone
+    AddrSpace *localSpace;      // if not NULL, victims must be its pages
+    int numReclaimed;           // pages evicted by the page daemon
+
+    bool Evictable(int frame);
+    TranslationEntry *EntryFor(int frame);
+    void Evict(int frame);      // take the frame from whoever has it
+    void CheckWatermarks();     // wake the page daemon if need be
+    void Claim(int frame, AddrSpace *owner, unsigned int vpn);
+    // record a newly allocated frame
+    int FindVictim();
+    int VictimFIFO();
+    int VictimClock();
+    int VictimEnhancedClock();
+    int VictimWSClock();
+};
+
+#endif // FRAMETABLE_H
@@ -0,0 +1,127 @@
+// shm.cc
+//	Routines to create and look up shared memory segments.
+//
+//	The frame table counts references to each frame; this only keeps
+//	track of which frames make up which segment, and how many address
+//	spaces have it attached.  Mapping the frames into an address space,
+//	and giving up its references, is AddrSpace's job.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "shm.h"
+#include "system.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// ShmTable::ShmTable
+// 	Initialize an empty table of segments.
+//----------------------------------------------------------------------
+
+ShmTable::ShmTable() {
+    segments = new List;
+    numPinned = 0;
+    numCreated = numAttached = 0;
+}
+
+ShmTable::~ShmTable() {
+    while (!segments->IsEmpty()) {
+        ShmSegment *seg = (ShmSegment *) segments->Remove();
+        delete[] seg->frames;
+        delete seg;
+    }
+    delete segments;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Find
+// 	Return the segment called "key", or NULL if there is none.
+//----------------------------------------------------------------------
+
+ShmSegment *
+ShmTable::Find(int key) {
+    for (ListElement *e = segments->getFirst(); e != NULL; e = e->next)
+        if (((ShmSegment *) e->item)->key == key)
+            return (ShmSegment *) e->item;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Create
+// 	Make a segment called "key" of "size" bytes, rounded up to whole
+//	pages, all zero, with frames from the frame table (which may evict
+//	pages of "creator" or anyone else to find them).  Segments may pin
+//	at most half of the frames between them, so that paging can go on.
+//
+//	Returns NULL if there already is a segment called "key", "size"
+//	makes no sense, or the frames can't be spared.
+//----------------------------------------------------------------------
+
+ShmSegment *
+ShmTable::Create(int key, int size, AddrSpace *creator) {
+    ShmSegment *seg;
+    int pages;
+
+    if (size <= 0 || size > MmapRegionSize || Find(key) != NULL)
+        return NULL;
+    pages = divRoundUp(size, PageSize);
+    if (numPinned + pages > frameTable->NumFrames() / 2)
+        return NULL;
+
+    seg = new ShmSegment;
+    seg->key = key;
+    seg->numPages = pages;
+    seg->frames = new int[pages];
+    seg->attached = 0;
+    for (int i = 0; i < pages; i++) {
+        seg->frames[i] = frameTable->AllocateShared(creator);
+        bzero(&(machine->mainMemory[seg->frames[i] * PageSize]), PageSize);
+    }
+    numPinned += pages;
+    numCreated++;
+    segments->Append((void *) seg);
+    DEBUG('v', "Shared segment %d created: %d pages\n", key, pages);
+    return seg;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Attach, ShmTable::Detach
+// 	Count the address spaces that have "seg" mapped.  The frame table
+//	has freed the frames by the time the last one detaches; the
+//	segment goes too, and its key may be used again.
+//----------------------------------------------------------------------
+
+void
+ShmTable::Attach(ShmSegment *seg) {
+    seg->attached++;
+    numAttached++;
+}
+
+void
+ShmTable::Detach(ShmSegment *seg) {
+    ASSERT(seg->attached > 0);
+    if (--seg->attached > 0)
+        return;
+    DEBUG('v', "Shared segment %d destroyed\n", seg->key);
+    for (int i = 1; i <= segments->ListLength(); i++)
+        if (segments->getItem(i) == (void *) seg) {
+            segments->RemoveItem(i);
+            break;
+        }
+    numPinned -= seg->numPages;
+    delete[] seg->frames;
+    delete seg;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Print
+// 	Print how many segments were made, and how much they were shared.
+//----------------------------------------------------------------------
+
+void
+ShmTable::Print() {
+    printf("Shared memory: %d segments created, %d attaches, "
+           "%d frames still pinned\n", numCreated, numAttached, numPinned);
+}
@@ -0,0 +1,62 @@
+// shm.h
+//	Data structures for shared memory segments: runs of physical
+//	page frames that several processes map into their address spaces
+//	at once, so that they can exchange data through memory rather
+//	than a byte at a time through syscalls.
+//
+//	A segment is named by a key chosen by the programs sharing it.
+//	ShmCreate makes a new one, zeroed, and attaches it to the caller;
+//	ShmAttach attaches one that exists already; a forked child is
+//	attached to its parent's.  Each attachment maps the segment in the
+//	region for mapped files (see Mapping), wherever there is room, and
+//	holds a reference to each of its frames in the frame table.  The
+//	frames are pinned, and go back to the free list -- and the
+//	segment is forgotten -- when the last process detaches, or exits.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SHM_H
+#define SHM_H
+
+#include "copyright.h"
+#include "list.h"
+
+class AddrSpace;
+
+// One segment.
+
+class ShmSegment {
+public:
+    int key;                    // what user programs call it
+    int numPages;
+    int *frames;                // per page: the frame holding it
+    int attached;               // address spaces mapping it
+};
+
+// The following class defines the table of segments.  Callers hold
+// the paging lock.
+
+class ShmTable {
+public:
+    ShmTable();
+    ~ShmTable();
+
+    ShmSegment *Find(int key);  // NULL if there is no such segment
+    ShmSegment *Create(int key, int size, AddrSpace *creator);
+    // a new zeroed segment of "size" bytes,
+    // attached by nobody yet; NULL if "key"
+    // is taken or memory is short
+    void Attach(ShmSegment *seg);   // one more address space maps it
+    void Detach(ShmSegment *seg);   // one fewer; forget it when none do
+
+    void Print();               // segment statistics
+
+private:
+    List *segments;
+    int numPinned;              // frames held by segments
+    int numCreated, numAttached;
+};
+
+#endif // SHM_H
@@ -0,0 +1,84 @@
+// swap.cc
+//	Routines to manage the swap area.
+//
+//	A page occupies SectorsPerPage consecutive sectors, starting at
+//	slot * SectorsPerPage, and moves as one multi-sector transfer.
+//	Callers serialize access with the paging lock; SynchDisk itself
+//	only allows one request at a time anyway.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "swap.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SwapSpace::SwapSpace
+// 	Initialize the swap area.  Nothing in it survives a reboot, so
+//	every slot starts out free.
+//
+//	"name" -- the UNIX file simulating the swap disk
+//----------------------------------------------------------------------
+
+SwapSpace::SwapSpace(char *name) {
+    disk = new SynchDisk(name);
+    slots = new BitMap(NumSwapSlots);
+    numPageIns = numPageOuts = 0;
+}
+
+SwapSpace::~SwapSpace() {
+    delete disk;
+    delete slots;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::Allocate, SwapSpace::Free
+// 	Reserve a slot for a page, or give it back.
+//----------------------------------------------------------------------
+
+int
+SwapSpace::Allocate() {
+    return slots->Find();
+}
+
+void
+SwapSpace::Free(int slot) {
+    ASSERT(slots->Test(slot));
+    slots->Clear(slot);
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadPage, SwapSpace::WritePage
+// 	Move one page between memory and its slot.  The calling thread
+//	waits for the disk.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadPage(int slot, char *into) {
+    ASSERT(slots->Test(slot));
+    disk->ReadSectors(slot * SectorsPerPage, SectorsPerPage, into);
+    numPageIns++;
+}
+
+void
+SwapSpace::WritePage(int slot, char *from) {
+    ASSERT(slots->Test(slot));
+    disk->WriteSectors(slot * SectorsPerPage, SectorsPerPage, from);
+    numPageOuts++;
+}
+
+//----------------------------------------------------------------------
+// SwapSpace::ReadPages
+// 	Read the pages in the "count" slots from "slot" on into "into",
+//	one after the other, as a single disk request.
+//----------------------------------------------------------------------
+
+void
+SwapSpace::ReadPages(int slot, int count, char *into) {
+    for (int i = 0; i < count; i++)
+        ASSERT(slots->Test(slot + i));
+    disk->ReadSectors(slot * SectorsPerPage, count * SectorsPerPage, into);
+    numPageIns += count;
+}
@@ -0,0 +1,49 @@
+// swap.h
+//	Data structures for the swap area -- backing store for pages
+//	evicted from physical memory.
+//
+//	The swap area is a simulated disk of its own (UNIX file "SWAP"),
+//	accessed through a SynchDisk, so paging traffic never competes
+//	with the file system for sectors.  It is divided into page-sized
+//	slots, tracked with a bitmap.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "copyright.h"
+#include "synchdisk.h"
+#include "bitmap.h"
+#include "machine.h"
+
+#define NumSwapSlots    (NumSectors / SectorsPerPage)
+
+class SwapSpace {
+public:
+    SwapSpace(char *name);      // initialize an empty swap area on the
+    // simulated disk "name"
+    ~SwapSpace();
+
+    int Allocate();             // reserve a slot; -1 if swap is full
+    void Free(int slot);        // give a slot back
+
+    void ReadPage(int slot, char *into);     // page in from "slot"
+    void WritePage(int slot, char *from);    // page out to "slot"
+    void ReadPages(int slot, int count, char *into);
+    // page in "count" pages from
+    // consecutive slots, in one request
+
+    int NumFree() { return slots->NumClear(); }
+
+    int numPageIns;             // pages read from swap
+    int numPageOuts;            // pages written to swap
+
+private:
+    SynchDisk *disk;
+    BitMap *slots;              // which slots hold a page
+};
+
+#endif // SWAP_H
@@ -0,0 +1,123 @@
+// textcache.cc
+//	Routines to look up and maintain the text page cache.
+//
+//	The frame table owns the frames; this is only the index from
+//	(executable, offset) to frame.  It is told about every frame it
+//	loses, so it never holds a stale entry.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "textcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TextCache::TextCache
+// 	Initialize an empty text page cache.
+//----------------------------------------------------------------------
+
+TextCache::TextCache() {
+    for (int i = 0; i < TextCacheBuckets; i++)
+        buckets[i] = new List;
+    numHits = numMisses = 0;
+}
+
+TextCache::~TextCache() {
+    for (int i = 0; i < TextCacheBuckets; i++) {
+        while (!buckets[i]->IsEmpty())
+            delete (TextPage *) buckets[i]->Remove();
+        delete buckets[i];
+    }
+}
+
+List *
+TextCache::BucketFor(int sector, int offset) {
+    return buckets[((unsigned) sector * 31 + (unsigned) offset / PageSize)
+                   % TextCacheBuckets];
+}
+
+//----------------------------------------------------------------------
+// TextCache::Find
+// 	Return the frame holding the page at "offset" in the executable
+//	whose header is at "sector", or -1 if it isn't cached.
+//----------------------------------------------------------------------
+
+int
+TextCache::Find(int sector, int offset) {
+    List *bucket = BucketFor(sector, offset);
+
+    for (int i = 1; i <= bucket->ListLength(); i++) {
+        TextPage *page = (TextPage *) bucket->getItem(i);
+        if (page->sector == sector && page->offset == offset) {
+            numHits++;
+            return page->frame;
+        }
+    }
+    numMisses++;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// TextCache::Insert, TextCache::Remove
+// 	Record that "frame" now holds the page, or that it no longer does.
+//----------------------------------------------------------------------
+
+void
+TextCache::Insert(int sector, int offset, int frame) {
+    BucketFor(sector, offset)->Append((void *) new TextPage(sector, offset,
+                                                            frame));
+}
+
+void
+TextCache::Remove(int sector, int offset) {
+    List *bucket = BucketFor(sector, offset);
+
+    for (int i = 1; i <= bucket->ListLength(); i++) {
+        TextPage *page = (TextPage *) bucket->getItem(i);
+        if (page->sector == sector && page->offset == offset) {
+            bucket->RemoveItem(i);
+            delete page;
+            return;
+        }
+    }
+    ASSERT(FALSE);              // wasn't cached
+}
+
+//----------------------------------------------------------------------
+// TextCache::ForgetFile
+// 	The file whose header is at "sector" has been removed, and the
+//	sector may soon hold another.  Drop its pages; processes still
+//	running it keep their mappings, but nobody new will find them.
+//
+//	Called by the file system, so this takes the paging lock itself.
+//----------------------------------------------------------------------
+
+void
+TextCache::ForgetFile(int sector) {
+    pagingLock->Acquire();
+    for (int b = 0; b < TextCacheBuckets; b++) {
+        List *bucket = buckets[b];
+        for (int i = 1; i <= bucket->ListLength();) {
+            TextPage *page = (TextPage *) bucket->getItem(i);
+            if (page->sector == sector) {
+                frameTable->Uncache(page->frame);
+                bucket->RemoveItem(i);
+                delete page;
+            } else
+                i++;
+        }
+    }
+    pagingLock->Release();
+}
+
+//----------------------------------------------------------------------
+// TextCache::Print
+// 	Print how often loading a code page found it already in memory.
+//----------------------------------------------------------------------
+
+void
+TextCache::Print() {
+    printf("Text cache: %d hits, %d misses\n", numHits, numMisses);
+}
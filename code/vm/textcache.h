@@ -0,0 +1,61 @@
+// textcache.h
+//	Data structures for the text page cache: physical frames holding
+//	pages of programs' code segments, looked up by the executable's
+//	file header sector and the page's offset in the file.
+//
+//	Code pages are never written, so every process running the same
+//	executable can map the same frame read-only, and a frame can stay
+//	cached after the last of them exits, ready for the next Exec.
+//	The frame table may still evict a cached page like any other.
+//
+//	A cached page is only valid as long as the file is; removing the
+//	file forgets its pages.  (Overwriting an executable in place while
+//	its pages are cached is not caught.)
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "copyright.h"
+#include "list.h"
+
+#define TextCacheBuckets    61  // hash table size; frames are few
+
+// One cached page.
+
+class TextPage {
+public:
+    TextPage(int s, int o, int f) { sector = s; offset = o; frame = f; }
+
+    int sector;                 // the executable's file header sector
+    int offset;                 // where in the file the page starts
+    int frame;                  // the frame holding it
+};
+
+// The following class defines the text page cache.  Callers hold the
+// paging lock.
+
+class TextCache {
+public:
+    TextCache();
+    ~TextCache();
+
+    int Find(int sector, int offset);   // frame caching the page, or -1
+    void Insert(int sector, int offset, int frame);
+    void Remove(int sector, int offset);    // the frame is being reused
+    void ForgetFile(int sector);        // the file is gone (takes the
+    // paging lock itself)
+
+    void Print();               // cache statistics
+
+private:
+    List *buckets[TextCacheBuckets];
+    int numHits, numMisses;
+
+    List *BucketFor(int sector, int offset);
+};
+
+#endif // TEXTCACHE_H
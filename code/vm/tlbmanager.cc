@@ -0,0 +1,239 @@
+// tlbmanager.cc
+//	Routines to refill the TLB on a miss and keep the page tables'
+//	use and dirty bits current.
+//
+//	The machine sets use and dirty bits only in the TLB entry it
+//	translated with.  They are folded back into the page table
+//	whenever an entry is replaced or dropped, and on request (Sync),
+//	and then cleared in the TLB, so that the page table's bits always
+//	mean "used (written) since the kernel last cleared them".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "tlbmanager.h"
+#include "system.h"
+
+static char *policyNames[] = {"random", "fifo", "lru"};
+
+//----------------------------------------------------------------------
+// TLBReplacePolicyNamed
+// 	Look up TLB replacement policy "name", as given to -tlbr.
+//----------------------------------------------------------------------
+
+bool
+TLBReplacePolicyNamed(char *name, TLBReplacePolicy *policy) {
+    for (int i = 0; i <= TLBLRUReplace; i++)
+        if (!strcmp(name, policyNames[i])) {
+            *policy = (TLBReplacePolicy) i;
+            return TRUE;
+        }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::TLBManager
+// 	Initialize the TLB manager.  The machine must already exist; its
+//	TLB starts out empty.
+//
+//	"replace" -- how to choose the entry a refill replaces
+//----------------------------------------------------------------------
+
+TLBManager::TLBManager(TLBReplacePolicy replace) {
+    policy = replace;
+    owner = new AddrSpace *[machine->tlbSize];
+    loadedAt = new int[machine->tlbSize];
+    for (int i = 0; i < machine->tlbSize; i++) {
+        owner[i] = NULL;
+        loadedAt[i] = 0;
+    }
+    numRefills = numSuperRefills = 0;
+}
+
+TLBManager::~TLBManager() {
+    delete[] owner;
+    delete[] loadedAt;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Refill
+// 	Handle a TLB miss on page "vpn" of "space", whose page table entry
+//	is valid.  This is the common case of a PageFaultException, so it
+//	only touches one set: vpn's, or if vpn is part of a superpage, the
+//	set of the superpage's first page.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Refill(AddrSpace *space, unsigned int vpn) {
+    unsigned int first = vpn & ~(SuperPageSpan - 1);
+    bool super = machine->tlbSuperPages && space->IsSuperPage(first);
+    unsigned int page = super ? first : vpn;
+    int i = Victim(machine->TLBSet(page));
+    TranslationEntry *entry = &(machine->tlb[i]);
+
+    ASSERT(space->PageEntry(vpn)->valid);
+    if (entry->valid)
+        WriteBack(i);
+    *entry = *(space->PageEntry(page));
+    entry->asid = space->getSpaceID();
+    entry->use = entry->dirty = FALSE;  // record only what happens next
+    entry->superPage = super;
+    if (super)
+        numSuperRefills++;
+    owner[i] = space;
+    loadedAt[i] = numRefills++;
+    machine->tlbLastUsed[i] = ++machine->tlbClock;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Victim
+// 	Return the entry to replace in the set starting at "set": an
+//	empty way if there is one, otherwise whichever the policy picks.
+//----------------------------------------------------------------------
+
+int
+TLBManager::Victim(int set) {
+    int ways = machine->tlbAssoc;
+    int victim = set;
+
+    for (int i = set; i < set + ways; i++)
+        if (!machine->tlb[i].valid)
+            return i;
+
+    switch (policy) {
+        case TLBRandomReplace:
+            victim = set + Random() % ways;
+            break;
+        case TLBFIFOReplace:
+            for (int i = set + 1; i < set + ways; i++)
+                if (loadedAt[i] < loadedAt[victim])
+                    victim = i;
+            break;
+        case TLBLRUReplace:
+            for (int i = set + 1; i < set + ways; i++)
+                if (machine->tlbLastUsed[i] < machine->tlbLastUsed[victim])
+                    victim = i;
+            break;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::WriteBack
+// 	Fold the use and dirty bits of valid entry "i" into its page
+//	table entry, and clear them in the TLB.  A superpage entry can't
+//	say which of its pages were touched, so it marks them all.
+//----------------------------------------------------------------------
+
+void
+TLBManager::WriteBack(int i) {
+    TranslationEntry *entry = &(machine->tlb[i]);
+    int span = entry->superPage ? SuperPageSpan : 1;
+
+    for (int k = 0; k < span; k++) {
+        TranslationEntry *pte = owner[i]->PageEntry(entry->virtualPage + k);
+        pte->use |= entry->use;
+        pte->dirty |= entry->dirty;
+    }
+    entry->use = entry->dirty = FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Find
+// 	Return a TLB entry translating page "vpn" of "space", whether
+//	or not "space" is the one running, or NULL if there is none.
+//	There may be two, one for the page and one for its superpage;
+//	the page's own comes first.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLBManager::Find(AddrSpace *space, unsigned int vpn) {
+    unsigned int first = vpn & ~(SuperPageSpan - 1);
+    int set = machine->TLBSet(vpn);
+
+    for (int i = set; i < set + machine->tlbAssoc; i++)
+        if (machine->tlb[i].valid && owner[i] == space &&
+            !machine->tlb[i].superPage &&
+            machine->tlb[i].virtualPage == (int) vpn)
+            return &(machine->tlb[i]);
+    set = machine->TLBSet(first);
+    for (int i = set; i < set + machine->tlbAssoc; i++)
+        if (machine->tlb[i].valid && owner[i] == space &&
+            machine->tlb[i].superPage &&
+            machine->tlb[i].virtualPage == (int) first)
+            return &(machine->tlb[i]);
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Invalidate
+// 	Drop the entries translating page "vpn" of "space", if any,
+//	keeping their use and dirty bits.  Called when the translation
+//	changes; that breaks up a superpage holding vpn, too.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Invalidate(AddrSpace *space, unsigned int vpn) {
+    TranslationEntry *entry;
+
+    while ((entry = Find(space, vpn)) != NULL) {
+        WriteBack(entry - machine->tlb);
+        entry->valid = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::InvalidateSpace
+// 	Drop every entry of "space", which is going away -- its ASID may
+//	be handed out again.
+//----------------------------------------------------------------------
+
+void
+TLBManager::InvalidateSpace(AddrSpace *space) {
+    for (int i = 0; i < machine->tlbSize; i++)
+        if (owner[i] == space) {
+            machine->tlb[i].valid = FALSE;
+            owner[i] = NULL;
+        }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Sync
+// 	Fold the use and dirty bits of every entry into the page tables.
+//	The frame table calls this before it looks at use bits.  Given a
+//	page, fold just the bits of the entries translating it.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Sync() {
+    for (int i = 0; i < machine->tlbSize; i++)
+        if (machine->tlb[i].valid)
+            WriteBack(i);
+}
+
+void
+TLBManager::Sync(AddrSpace *space, unsigned int vpn) {
+    unsigned int first = vpn & ~(SuperPageSpan - 1);
+
+    for (int i = 0; i < machine->tlbSize; i++) {
+        TranslationEntry *entry = &(machine->tlb[i]);
+        if (entry->valid && owner[i] == space &&
+            entry->virtualPage == (int) (entry->superPage ? first : vpn))
+            WriteBack(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Print
+// 	Print the TLB's shape and how often it was refilled; the hit
+//	rate is in the machine statistics.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Print() {
+    printf("TLB: %d entries, %d-way, %s replacement, %d refills "
+           "(%d superpages)\n", machine->tlbSize, machine->tlbAssoc,
+           policyNames[policy], numRefills, numSuperRefills);
+}
@@ -0,0 +1,73 @@
+// tlbmanager.h
+//	Data structures for the kernel side of a software-managed TLB:
+//	refilling it from the page tables on a miss, and keeping the
+//	page tables' use and dirty bits up to date.
+//
+//	Entries are tagged with the address space's ID (its ASID), so
+//	they survive context switches; an address space's entries are
+//	only thrown away when it lets go of its pages.  Which way of a
+//	set to replace is chosen at startup (-tlbr):
+//
+//	  random  -- any way of the set
+//	  fifo    -- the way loaded longest ago
+//	  lru     -- the way that translated an address longest ago
+//
+//	With superpages on (-sp), a miss in a run of pages that the
+//	address space holds as a superpage loads one entry for the lot.
+//	Its use and dirty bits then stand for every page of the run.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLBMANAGER_H
+#define TLBMANAGER_H
+
+#include "copyright.h"
+#include "translate.h"
+
+class AddrSpace;
+
+enum TLBReplacePolicy { TLBRandomReplace, TLBFIFOReplace, TLBLRUReplace };
+
+// Look up a policy by its -tlbr name; FALSE if there is no such policy.
+extern bool TLBReplacePolicyNamed(char *name, TLBReplacePolicy *policy);
+
+// The following class defines the TLB manager.  There is one, for
+// the machine's one TLB.
+
+class TLBManager {
+public:
+    TLBManager(TLBReplacePolicy replace);
+    ~TLBManager();
+
+    void Refill(AddrSpace *space, unsigned int vpn);
+    // load space's (valid) translation
+    // for vpn, replacing an entry of
+    // its set if need be
+    TranslationEntry *Find(AddrSpace *space, unsigned int vpn);
+    // an entry translating space's vpn,
+    // or NULL
+    void Invalidate(AddrSpace *space, unsigned int vpn);
+    // drop space's entry for vpn
+    void InvalidateSpace(AddrSpace *space);     // drop all of space's
+    void Sync();                // fold every entry's use and dirty
+    // bits into its page table
+    void Sync(AddrSpace *space, unsigned int vpn);
+    // ... just those of the entries
+    // translating space's vpn
+
+    void Print();               // TLB statistics
+
+private:
+    TLBReplacePolicy policy;
+    AddrSpace **owner;          // per entry: whose translation it is
+    int *loadedAt;              // per entry: when it was refilled, for FIFO
+    int numRefills;
+    int numSuperRefills;        // of which loaded a superpage
+
+    int Victim(int set);        // which way of "set" to replace
+    void WriteBack(int i);      // fold entry i's bits into its page table
+};
+
+#endif // TLBMANAGER_H